@@ -4,6 +4,11 @@
    - Compile (Linux/macOS):
        gcc retro_mario_c.c -o retro_mario_c $(sdl2-config --cflags --libs) -lSDL2_ttf
      Or Windows (MinGW) adjust include/linker flags for SDL2 and SDL2_ttf.
+   - As a library: compile with -DRETRO_NO_MAIN and drive the simulation
+     through the LIBRARY API (game_create / game_step / game_observe) and
+     the BATCH runner (batch_step); see those sections.
+   - Benchmarks: platformer_bench.c builds this file as a library and times
+     the hot paths (level build, collision, enemies, pickups, drawing).
 
    Controls:
      Left/Right / A/D : move
@@ -11,6 +16,40 @@
      R                : restart level
      Enter            : start/proceed on menus
      Esc              : quit
+     F3               : toggle debug stats overlay
+     F4               : toggle frame profiler overlay
+
+   Options:
+     --hz N           : simulation tick rate (default 60)
+     --no-merge       : keep one solid per tile instead of merging runs
+     --headless [FILE]: no window; replay an input script (see run_headless)
+                        and print ticks/s and a final-state checksum
+     --ticks N        : with --headless, run N ticks (looping the script)
+     --rollback N     : with --headless, before every tick simulate N ticks
+                        ahead, then roll back (exercises snapshots)
+     --batch N        : with --headless, step N independent games with
+                        pseudo-random inputs across the job pool for --ticks
+                        ticks (default 10000) and print steps/s
+     --prof-csv FILE  : on exit, write the recent per-frame phase timings
+     --levels DIR     : play DIR/level001.lvl (or .txt), level002..., instead
+                        of the built-in maps, each built in the background
+                        before it starts
+     --compile-level IN.txt OUT.lvl : convert a text map to the binary format
+     --bake-levels FILE : write the built-in maps as baked_levels.h tables
+     --check-baked    : compare baked_levels.h against the parsed maps
+     --threads N      : job pool worker threads (default CPUs - 1)
+     --sim-margin N   : simulate only entities within N tiles of the view,
+                        and keep only the grid around them of a long .lvl
+                        level in memory (default 32); -1 simulates and
+                        keeps the whole level
+     --pacing MODE    : vsync (default), cap (wait for --fps on a precise
+                        timer) or uncapped
+     --fps N          : frame rate for --pacing cap
+     --telemetry FILE : log gameplay events to FILE (see TELEMETRY)
+     --font FILE      : TrueType font for text (default DejaVu Sans Bold)
+     --font-cache FILE: prebuilt glyph atlas, written on the first run and
+                        used instead of the font afterwards (default
+                        font.cache in the SDL pref directory)
 
    Note: This is NOT the original Nintendo game. It's an original reimplementation
    of classic platformer mechanics with simple drawn sprites.
@@ -22,12 +61,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 /* ---------------- CONFIG ---------------- */
 const int SCREEN_W = 960;
 const int SCREEN_H = 540;
 const int TILE = 48;
-const int FPS = 60;
+const int FPS = 60;            /* default frame rate for --pacing cap (--fps N) */
+const float TUNING_HZ = 60.0f; /* per-tick constants below were tuned for this tick rate */
+const int MAX_TICKS_PER_FRAME = 8;
+const double MAX_FRAME_TIME = 0.25; /* longest frame fed to the simulation (s) */
+int sim_hz = 60;               /* simulation ticks per second (--hz N) */
 const float GRAVITY = 0.60f;
 const float MAX_XSPEED = 6.0f;
 const float JUMP_VEL = -12.0f;
@@ -87,6 +143,8 @@ const char *LEVELS[][8] = {
     }
 };
 const int NUM_LEVELS = 3;
+int num_levels = 3;             /* NUM_LEVELS, or the file count with --levels */
+const char *level_dir = NULL;   /* --levels DIR */
 
 /* ---------------- STRUCTS ---------------- */
 typedef struct {
@@ -99,35 +157,106 @@ typedef struct {
     int score;
     int lives;
     SDL_FPoint spawn;
+    SDL_FPoint prev;    /* position at the start of the last tick (for interpolation) */
 } Player;
 
+/* Entity stores: structure-of-arrays, holding only live entities in
+   [0, count), sorted by x. Collected / stomped entities are removed by
+   shifting the tail down, so every pass walks a dense range with no
+   dead-entry branches, and the entities near any x are one contiguous
+   span (see store_span). The arrays live in the level arena, sized (cap)
+   for the level's spawns. */
+typedef struct {
+    int count, cap;
+    int *x, *y, *w, *h;
+} CoinStore;
+
 typedef struct {
-    SDL_Rect r;
-    int active;
-    int dir; /* -1 or +1 */
-    float speed;
-} Enemy;
+    int count, cap;
+    int *x, *y, *w, *h;
+    int *dir;       /* -1 or +1 */
+    float *speed;   /* pixels per tuning tick */
+    float *fx;      /* sub-pixel x; x[] is its rounded value */
+    float *prev_x;  /* fx at the start of the last tick */
+} EnemyStore;
 
 typedef struct {
-    SDL_Rect r;
-    int active;
-} Coin;
+    int count, cap;
+    int *x, *y, *w, *h;
+} MushStore;
 
+/* broadphase entry for one dynamic entity (see BROADPHASE) */
+enum {PROXY_ENEMY, PROXY_MUSH};
 typedef struct {
-    SDL_Rect r;
-    int active;
-} Mushroom;
+    int minx, maxx, miny, maxy;
+    int kind, idx;  /* PROXY_* and index into that store */
+} Proxy;
+
+/* ---------------- RENDER queue ----------------
+   draw_rect only records a coloured rect; render_flush submits everything
+   queued since the last flush. With SDL >= 2.0.18 that is one
+   SDL_RenderGeometry call (per-vertex colours keep painter's order);
+   older SDL gets one SDL_RenderFillRects per run of same-coloured rects.
+   Flush before anything that isn't a queued rect (texture copies, render
+   target switches, present) so layering stays correct. */
+#define MAX_QUEUED_RECTS 2048
+SDL_Rect queued_rects[MAX_QUEUED_RECTS];
+SDL_Color queued_cols[MAX_QUEUED_RECTS];
+int queued_count = 0;
+int render_batches = 0;   /* draw submissions this frame */
+int last_render_batches = 0;
+#if SDL_VERSION_ATLEAST(2,0,18)
+SDL_Vertex queue_verts[MAX_QUEUED_RECTS * 4];
+int queue_indices[MAX_QUEUED_RECTS * 6];
+int queue_indices_ready = 0;
+#endif
+
+void render_flush(SDL_Renderer *ren) {
+    if (queued_count == 0) return;
+#if SDL_VERSION_ATLEAST(2,0,18)
+    if (!queue_indices_ready) {
+        for (int i=0;i<MAX_QUEUED_RECTS;i++){
+            int *ix = &queue_indices[i*6];
+            ix[0] = i*4; ix[1] = i*4+1; ix[2] = i*4+2;
+            ix[3] = i*4; ix[4] = i*4+2; ix[5] = i*4+3;
+        }
+        queue_indices_ready = 1;
+    }
+    for (int i=0;i<queued_count;i++){
+        SDL_Rect r = queued_rects[i];
+        SDL_Color c = queued_cols[i];
+        SDL_Vertex *v = &queue_verts[i*4];
+        v[0] = (SDL_Vertex){{(float)r.x, (float)r.y}, c, {0, 0}};
+        v[1] = (SDL_Vertex){{(float)(r.x + r.w), (float)r.y}, c, {0, 0}};
+        v[2] = (SDL_Vertex){{(float)(r.x + r.w), (float)(r.y + r.h)}, c, {0, 0}};
+        v[3] = (SDL_Vertex){{(float)r.x, (float)(r.y + r.h)}, c, {0, 0}};
+    }
+    SDL_RenderGeometry(ren, NULL, queue_verts, queued_count * 4, queue_indices, queued_count * 6);
+    render_batches++;
+#else
+    for (int i=0;i<queued_count;){
+        SDL_Color c = queued_cols[i];
+        int n = 1;
+        while (i + n < queued_count && memcmp(&queued_cols[i+n], &c, sizeof(c)) == 0) n++;
+        SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRects(ren, &queued_rects[i], n);
+        render_batches++;
+        i += n;
+    }
+#endif
+    queued_count = 0;
+}
 
 /* ---------------- HELPERS ---------------- */
 void draw_rect(SDL_Renderer *ren, int x, int y, int w, int h, SDL_Color col) {
-    SDL_SetRenderDrawColor(ren, col.r, col.g, col.b, col.a);
-    SDL_Rect rr = {x,y,w,h};
-    SDL_RenderFillRect(ren, &rr);
+    if (w <= 0 || h <= 0) return;
+    if (queued_count >= MAX_QUEUED_RECTS) render_flush(ren);
+    queued_rects[queued_count] = (SDL_Rect){x,y,w,h};
+    queued_cols[queued_count] = col;
+    queued_count++;
 }
 void draw_frect(SDL_Renderer *ren, SDL_FRect fr, SDL_Color col) {
-    SDL_SetRenderDrawColor(ren, col.r, col.g, col.b, col.a);
-    SDL_Rect rr = {(int)roundf(fr.x),(int)roundf(fr.y),(int)roundf(fr.w),(int)roundf(fr.h)};
-    SDL_RenderFillRect(ren, &rr);
+    draw_rect(ren, (int)roundf(fr.x), (int)roundf(fr.y), (int)roundf(fr.w), (int)roundf(fr.h), col);
 }
 int aabb_int(SDL_Rect a, SDL_Rect b) {
     return !(a.x + a.w <= b.x || a.x >= b.x + b.w || a.y + a.h <= b.y || a.y >= b.y + b.h);
@@ -136,544 +265,3178 @@ int aabb_frect(SDL_FRect a, SDL_FRect b) {
     return !(a.x + a.w <= b.x || a.x >= b.x + b.w || a.y + a.h <= b.y || a.y >= b.y + b.h);
 }
 
-/* ---------------- LEVEL BUILD ---------------- */
-#define MAX_SOLIDS 1024
-SDL_Rect solids[MAX_SOLIDS];
-int solids_count = 0;
-
-#define MAX_COINS 512
-Coin coins[MAX_COINS];
-int coin_count = 0;
-
-#define MAX_ENEMIES 128
-Enemy enemies[MAX_ENEMIES];
-int enemy_count = 0;
-
-#define MAX_MUSH 64
-Mushroom mush[MAX_MUSH];
-int mush_count = 0;
-
-SDL_Rect goal_rect;
-int goal_exists = 0;
-int world_width = 0;
-
-void build_level(const char *map_lines[], int rows) {
-    solids_count = coin_count = enemy_count = mush_count = 0;
-    goal_exists = 0;
-    world_width = (int)strlen(map_lines[0]) * TILE;
-    for (int j=0;j<rows;j++){
-        const char *row = map_lines[j];
-        for (int i=0;i<(int)strlen(row);i++){
-            char ch = row[i];
-            int x = i*TILE;
-            int y = j*TILE;
-            if (ch=='X' || ch=='=') {
-                if (solids_count < MAX_SOLIDS) {
-                    solids[solids_count++] = (SDL_Rect){x,y,TILE,TILE};
-                }
-            } else if (ch=='t') {
-                if (solids_count < MAX_SOLIDS) {
-                    solids[solids_count++] = (SDL_Rect){x,y+TILE/2,TILE,TILE/2};
-                }
-            } else if (ch=='C') {
-                if (coin_count < MAX_COINS) {
-                    coins[coin_count++] = (Coin){.r = {x+TILE/4, y+TILE/4, TILE/2, TILE/2}, .active = 1};
-                }
-            } else if (ch=='E') {
-                if (enemy_count < MAX_ENEMIES) {
-                    enemies[enemy_count++] = (Enemy){.r = {x+6,y+8,TILE-12,TILE-16}, .active = 1, .dir = -1, .speed = 1.2f};
-                }
-            } else if (ch=='M') {
-                if (mush_count < MAX_MUSH) {
-                    mush[mush_count++] = (Mushroom){.r = {x+12,y+12,TILE-24,TILE-24}, .active = 1};
-                }
-            } else if (ch=='F') {
-                goal_rect = (SDL_Rect){x+TILE/2-6,y-4*TILE,12,4*TILE};
-                goal_exists = 1;
-            }
+/* ---------------- BATCH overlap ----------------
+   One query rect against packed x/y/w/h arrays (the SoA entity stores),
+   AABB_LANES entities per step: AVX2 when built with -mavx2 (or
+   -march=native), SSE2 on any x86-64, NEON on AArch64, scalar otherwise.
+   Same overlap rule as aabb_int. */
+#if defined(__AVX2__)
+#define AABB_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define AABB_LANES 4
+#else
+#define AABB_LANES 1
+#endif
+
+/* bit k set if entity i+k overlaps q, for AABB_LANES entities from i */
+unsigned aabb_mask(SDL_Rect q, const int *x, const int *y, const int *w, const int *h, int i) {
+#if defined(__AVX2__)
+    __m256i ex = _mm256_loadu_si256((const __m256i *)(x + i));
+    __m256i ey = _mm256_loadu_si256((const __m256i *)(y + i));
+    __m256i ex1 = _mm256_add_epi32(ex, _mm256_loadu_si256((const __m256i *)(w + i)));
+    __m256i ey1 = _mm256_add_epi32(ey, _mm256_loadu_si256((const __m256i *)(h + i)));
+    __m256i m = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(q.x + q.w), ex), _mm256_cmpgt_epi32(ex1, _mm256_set1_epi32(q.x))),
+        _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(q.y + q.h), ey), _mm256_cmpgt_epi32(ey1, _mm256_set1_epi32(q.y))));
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+#elif AABB_LANES == 4 && !defined(__ARM_NEON)
+    __m128i ex = _mm_loadu_si128((const __m128i *)(x + i));
+    __m128i ey = _mm_loadu_si128((const __m128i *)(y + i));
+    __m128i ex1 = _mm_add_epi32(ex, _mm_loadu_si128((const __m128i *)(w + i)));
+    __m128i ey1 = _mm_add_epi32(ey, _mm_loadu_si128((const __m128i *)(h + i)));
+    __m128i m = _mm_and_si128(
+        _mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(q.x + q.w), ex), _mm_cmpgt_epi32(ex1, _mm_set1_epi32(q.x))),
+        _mm_and_si128(_mm_cmpgt_epi32(_mm_set1_epi32(q.y + q.h), ey), _mm_cmpgt_epi32(ey1, _mm_set1_epi32(q.y))));
+    return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(m));
+#elif AABB_LANES == 4
+    int32x4_t ex = vld1q_s32(x + i), ey = vld1q_s32(y + i);
+    int32x4_t ex1 = vaddq_s32(ex, vld1q_s32(w + i)), ey1 = vaddq_s32(ey, vld1q_s32(h + i));
+    uint32x4_t m = vandq_u32(
+        vandq_u32(vcgtq_s32(vdupq_n_s32(q.x + q.w), ex), vcgtq_s32(ex1, vdupq_n_s32(q.x))),
+        vandq_u32(vcgtq_s32(vdupq_n_s32(q.y + q.h), ey), vcgtq_s32(ey1, vdupq_n_s32(q.y))));
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(m, vld1q_u32(lane_bits)));
+#else
+    return (unsigned)aabb_int(q, (SDL_Rect){x[i], y[i], w[i], h[i]});
+#endif
+}
+
+/* index of the first entity in [start, count) overlapping q, or count */
+int overlap_next(SDL_Rect q, const int *x, const int *y, const int *w, const int *h, int start, int count) {
+    int i = start;
+    for (; i + AABB_LANES <= count; i += AABB_LANES){
+        unsigned m = aabb_mask(q, x, y, w, h, i);
+        if (m) {
+            while (!(m & 1u)) { m >>= 1; i++; }
+            return i;
         }
     }
+    for (; i < count; i++){
+        if (aabb_int(q, (SDL_Rect){x[i], y[i], w[i], h[i]})) return i;
+    }
+    return count;
 }
 
-/* ---------------- COLLISION helpers for player (float rect) ---------------- */
-void resolve_horz_collision(Player *p) {
-    SDL_FRect fr = p->r;
-    fr.x += p->vx;
-    /* build integer rect to test against solids */
-    SDL_Rect test = {(int)roundf(fr.x),(int)roundf(fr.y),(int)roundf(fr.w),(int)roundf(fr.h)};
-    for (int i=0;i<solids_count;i++){
-        if (aabb_int(test, solids[i])) {
-            if (p->vx > 0) {
-                p->r.x = solids[i].x - p->r.w;
-            } else if (p->vx < 0) {
-                p->r.x = solids[i].x + solids[i].w;
-            }
-            p->vx = 0;
-            return;
-        }
+/* ---------------- PROFILER ----------------
+   Scoped phase timers on the performance counter. A phase may be entered
+   several times per frame (once per sim tick); prof_frame_end folds the
+   frame's totals into a ring of recent frames that the F4 overlay and the
+   --prof-csv dump read from. Phases must not nest inside each other. */
+enum {PROF_INPUT, PROF_COLLIDE, PROF_ENEMIES, PROF_PICKUPS, PROF_DRAW, PROF_TEXT, PROF_PRESENT, PROF_FRAME, PROF_COUNT};
+const char *PROF_NAMES[PROF_COUNT] = {"input", "collide", "enemies", "pickups", "draw", "text", "present", "frame"};
+#define PROF_HISTORY 600   /* frames kept for the CSV dump */
+#define PROF_WINDOW 120    /* frames summarised by the overlay */
+Uint64 prof_start[PROF_COUNT];
+Uint64 prof_accum[PROF_COUNT];
+float prof_hist[PROF_HISTORY][PROF_COUNT];   /* ms per frame */
+int prof_frames = 0;   /* frames recorded so far (keeps counting past PROF_HISTORY) */
+int show_prof = 0;
+int prof_on = 0;   /* only the windowed game profiles; sim code may run on many threads */
+
+void prof_begin(int ph) { if (prof_on) prof_start[ph] = SDL_GetPerformanceCounter(); }
+void prof_end(int ph) { if (prof_on) prof_accum[ph] += SDL_GetPerformanceCounter() - prof_start[ph]; }
+
+/* close the frame; frame_ms is the full frame-to-frame time */
+void prof_frame_end(double frame_ms) {
+    double ms_per_count = 1000.0 / SDL_GetPerformanceFrequency();
+    float *row = prof_hist[prof_frames % PROF_HISTORY];
+    for (int p=0;p<PROF_COUNT;p++){
+        row[p] = (float)(prof_accum[p] * ms_per_count);
+        prof_accum[p] = 0;
     }
-    p->r.x += p->vx;
+    row[PROF_FRAME] = (float)frame_ms;
+    prof_frames++;
 }
-void resolve_vert_collision(Player *p) {
-    SDL_FRect fr = p->r;
-    fr.y += p->vy;
-    SDL_Rect test = {(int)roundf(fr.x),(int)roundf(fr.y),(int)roundf(fr.w),(int)roundf(fr.h)};
-    p->on_ground = 0;
-    for (int i=0;i<solids_count;i++){
-        if (aabb_int(test, solids[i])) {
-            if (p->vy > 0) {
-                p->r.y = solids[i].y - p->r.h;
-                p->on_ground = 1;
-            } else if (p->vy < 0) {
-                p->r.y = solids[i].y + solids[i].h;
-            }
-            p->vy = 0;
-            return;
-        }
+
+/* min/avg/max of a phase over the last `window` recorded frames */
+void prof_summary(int ph, int window, float *mn, float *avg, float *mx) {
+    int n = prof_frames < window ? prof_frames : window;
+    *mn = *avg = *mx = 0;
+    if (n == 0) return;
+    double sum = 0;
+    *mn = 1e9f;
+    for (int i=0;i<n;i++){
+        float v = prof_hist[(prof_frames - 1 - i) % PROF_HISTORY][ph];
+        if (v < *mn) *mn = v;
+        if (v > *mx) *mx = v;
+        sum += v;
     }
-    p->r.y += p->vy;
+    *avg = (float)(sum / n);
 }
 
-/* ---------------- ENEMY movement ---------------- */
-void update_enemies(float dt) {
-    for (int i=0;i<enemy_count;i++){
-        if (!enemies[i].active) continue;
-        Enemy *e = &enemies[i];
-        float oldx = e->r.x;
-        e->r.x += (int)roundf(e->dir * e->speed);
-        /* horizontal collision with solids */
-        for (int s=0;s<solids_count;s++){
-            if (aabb_int(e->r, solids[s])) {
-                /* undo and flip */
-                e->r.x = (int)roundf(oldx);
-                e->dir *= -1;
-                break;
-            }
-        }
-        /* basic ground ahead check; if no block below ahead, flip */
-        int ahead_x = e->r.x + (e->dir>0? e->r.w + 2 : -4);
-        int foot_y = e->r.y + e->r.h + 2;
-        SDL_Rect foot = {ahead_x, foot_y, 2, 2};
-        int found=0;
-        for (int s=0;s<solids_count;s++){
-            if (aabb_int(foot, solids[s])) { found=1; break; }
-        }
-        if (!found) e->dir *= -1;
+int prof_write_csv(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "cannot write profile %s\n", path); return 0; }
+    fprintf(f, "frame");
+    for (int p=0;p<PROF_COUNT;p++) fprintf(f, ",%s_ms", PROF_NAMES[p]);
+    fprintf(f, "\n");
+    int first = prof_frames > PROF_HISTORY ? prof_frames - PROF_HISTORY : 0;
+    for (int fr=first; fr<prof_frames; fr++){
+        fprintf(f, "%d", fr);
+        for (int p=0;p<PROF_COUNT;p++) fprintf(f, ",%.4f", prof_hist[fr % PROF_HISTORY][p]);
+        fprintf(f, "\n");
     }
+    fclose(f);
+    return 1;
 }
 
-/* ---------------- RENDER helpers ---------------- */
-void draw_level(SDL_Renderer *ren, int camx) {
-    /* solids */
-    for (int i=0;i<solids_count;i++){
-        SDL_Rect r = solids[i];
-        r.x -= camx;
-        draw_rect(ren, r.x, r.y, r.w, r.h, BLOCK);
-        if (r.h == TILE) {
-            draw_rect(ren, r.x, r.y, r.w, 6, (SDL_Color){230,150,90,255});
+/* ---------------- LEVEL ARENA ----------------
+   All per-level storage (solids, the tile grids, the entity stores) is
+   carved from one block, sized from the level's contents in level_begin.
+   Starting a level resets it in O(1) and frees the previous level's data
+   all at once; the block itself only grows when a bigger level is built,
+   so nothing is allocated during play. */
+typedef struct {
+    unsigned char *base;
+    size_t cap, used;
+} Arena;
+
+#define ARENA_ALIGN 16
+
+size_t arena_size(size_t n) { return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1); }
+
+/* drop everything and make room for n bytes */
+int arena_reset(Arena *a, size_t n) {
+    a->used = 0;
+    if (n <= a->cap) return 1;
+    unsigned char *p = malloc(n);
+    if (!p) return 0;
+    free(a->base);
+    a->base = p;
+    a->cap = n;
+    return 1;
+}
+
+void *arena_alloc(Arena *a, size_t n) {
+    n = arena_size(n);
+    if (a->cap - a->used < n) return NULL;
+    void *p = a->base + a->used;
+    a->used += n;
+    return p;
+}
+
+void arena_free(Arena *a) {
+    free(a->base);
+    memset(a, 0, sizeof(*a));
+}
+
+/* read-only view of a whole file; mmap where available */
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    int mapped;
+} FileView;
+
+int file_view_open(FileView *v, const char *path) {
+    memset(v, 0, sizeof(*v));
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            v->data = p; v->size = (size_t)st.st_size; v->mapped = 1;
         }
     }
-    /* grass caps (visual) - scan level rows */
-    /* not drawing separate t-caps here since solids include t */
+    close(fd);
+    if (v->mapped) return 1;
+#endif
+    /* no mmap: read it in */
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *buf = n > 0 ? malloc((size_t)n) : NULL;
+    if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) { free(buf); fclose(f); return 0; }
+    fclose(f);
+    v->data = buf; v->size = (size_t)n;
+    return 1;
 }
 
-void draw_player(SDL_Renderer *ren, Player *p, int camx) {
-    SDL_FRect pr = p->r;
-    SDL_Rect rr = {(int)roundf(pr.x)-camx, (int)roundf(pr.y), (int)roundf(pr.w), (int)roundf(pr.h)};
-    SDL_Color col = p->big ? PLAYER_BIG_COL : PLAYER_COL;
-    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, col);
-    /* small hat */
-    draw_rect(ren, rr.x+4, rr.y-6, rr.w-8, 6, (SDL_Color){30,30,30,255});
+void file_view_close(FileView *v) {
+#ifndef _WIN32
+    if (v->mapped) munmap((void *)v->data, v->size);
+    else
+#endif
+    free((void *)v->data);
+    memset(v, 0, sizeof(*v));
 }
 
-void draw_enemy(SDL_Renderer *ren, Enemy *e, int camx) {
-    SDL_Rect rr = e->r;
-    rr.x -= camx;
-    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, ENEMY_COL);
-    draw_rect(ren, rr.x + rr.w/2 - 2, rr.y + 8, 4, 4, (SDL_Color){250,240,220,255});
+/* ---------------- WORLD ----------------
+   Everything the simulation reads or writes for one running level lives
+   in a World, and every simulation function takes the World it works on,
+   so any number of them can run side by side (see the BATCH runner). */
+enum {TILE_EMPTY, TILE_FULL, TILE_CAP};
+
+/* the level is handled in CHUNK_TILES-wide columns: the unit of the
+   static-layer texture cache and of the active region */
+#define CHUNK_TILES 16
+#define CHUNK_W (CHUNK_TILES * TILE)
+int sim_margin = 2 * CHUNK_TILES;   /* tiles; --sim-margin, < 0 = whole level (see ACTIVE REGION) */
+
+/* a resident column chunk of a paged level (see TILE PAGES) */
+typedef struct {
+    int chunk;              /* chunk held, or -1 */
+    Uint32 last_used;       /* TilePages clock when last wanted */
+    int cols;               /* CHUNK_TILES, fewer in the last chunk */
+    unsigned char *kind;    /* TILE_* of the chunk's cells, row-major, cols per row */
+    SDL_Rect *solids;       /* the chunk's solids, merged within the chunk */
+    int solids_count;
+} TilePage;
+
+typedef struct {
+    int count, chunks;      /* pages, and chunks in the level */
+    Uint32 clock;           /* bumped by every tile_pages_window */
+    int page_ins;           /* chunks copied in since the level was built */
+    int *page_of;           /* per chunk: its page, or -1 */
+    int *scratch;           /* one chunk's cell -> solid map, for emit_solids */
+    TilePage *page;
+} TilePages;
+
+typedef struct {
+    Arena arena;            /* per-level storage, see LEVEL ARENA */
+    size_t state_bytes;     /* mutable prefix of arena (see level_begin) */
+    int level_serial;       /* unique per build in any World, for caches of level data */
+    int width;              /* scrollable width in pixels */
+
+    SDL_Rect *solids;
+    int solids_count, solids_cap;
+    /* Tile occupancy grid: for every TILE cell, the index into solids[] of
+       the solid built from that cell (full block or half-height 't' cap),
+       or -1. Collision queries look up only the cells a rect overlaps
+       instead of scanning the whole solids[] array. Row-major, grid_cols
+       per row; tile_kind holds the TILE_* of each cell in the same layout. */
+    int *solid_grid;
+    unsigned char *tile_kind;
+    int grid_cols, grid_rows;
+
+    CoinStore coins;
+    EnemyStore enemies;
+    MushStore mush;
+    Proxy *proxies;         /* broadphase list, sorted by minx */
+    int proxy_count;
+    int proxies_valid;      /* proxies[] matches the current stores */
+    int proxy_span[4];      /* enemy and mushroom index spans proxies[] covers */
+
+    SDL_Rect goal_rect;
+    int goal_exists;
+    SDL_FPoint player_start;    /* where the player spawns (see player_start) */
+    int player_start_known;     /* set by baked levels, else found on first use */
+
+    /* Paged levels (long .lvl files, see TILE PAGES) have no whole-level solids,
+       solid_grid or tile_kind: the file stays mapped, pages holds the
+       column chunks around the view, and tile_at reads any other cell
+       straight from file_tiles. pages is NULL for every other level. */
+    TilePages *pages;           /* in the arena, after the mutable prefix */
+    FileView file;
+    const unsigned char *file_tiles;
+} World;
+
+/* ---------------- LEVEL BUILD ---------------- */
+SDL_Rect coin_rect(const World *world, int i) { return (SDL_Rect){world->coins.x[i], world->coins.y[i], world->coins.w[i], world->coins.h[i]}; }
+SDL_Rect enemy_rect(const World *world, int i) { return (SDL_Rect){world->enemies.x[i], world->enemies.y[i], world->enemies.w[i], world->enemies.h[i]}; }
+SDL_Rect mush_rect(const World *world, int i) { return (SDL_Rect){world->mush.x[i], world->mush.y[i], world->mush.w[i], world->mush.h[i]}; }
+
+void add_coin(World *world, SDL_Rect r) {
+    if (world->coins.count >= world->coins.cap) return;
+    int n = world->coins.count++;
+    world->coins.x[n] = r.x; world->coins.y[n] = r.y; world->coins.w[n] = r.w; world->coins.h[n] = r.h;
+}
+void add_enemy(World *world, SDL_Rect r, int dir, float speed) {
+    if (world->enemies.count >= world->enemies.cap) return;
+    int n = world->enemies.count++;
+    world->enemies.x[n] = r.x; world->enemies.y[n] = r.y; world->enemies.w[n] = r.w; world->enemies.h[n] = r.h;
+    world->enemies.dir[n] = dir; world->enemies.speed[n] = speed;
+    world->enemies.fx[n] = world->enemies.prev_x[n] = (float)r.x;
+}
+void add_mush(World *world, SDL_Rect r) {
+    if (world->mush.count >= world->mush.cap) return;
+    int n = world->mush.count++;
+    world->mush.x[n] = r.x; world->mush.y[n] = r.y; world->mush.w[n] = r.w; world->mush.h[n] = r.h;
 }
 
-void draw_coin(SDL_Renderer *ren, Coin *c, int camx) {
-    SDL_Rect rr = c->r;
-    rr.x -= camx;
-    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, COIN_COL);
+/* drop element i of an n-element array, keeping the order */
+void array_erase(void *a, size_t elem, int i, int n) {
+    memmove((char *)a + i * elem, (char *)a + (i + 1) * elem, (n - i - 1) * elem);
 }
 
-void draw_mush(SDL_Renderer *ren, Mushroom *m, int camx) {
-    SDL_Rect rr = m->r;
-    rr.x -= camx;
-    /* cap */
-    draw_rect(ren, rr.x, rr.y, rr.w, rr.h/2, MUSH_COL);
-    /* stem */
-    draw_rect(ren, rr.x + rr.w/4, rr.y + rr.h/4, rr.w/2, rr.h/2, (SDL_Color){250,230,200,255});
+/* the entities after slot i shift down one, so slot i holds the next one */
+void remove_coin(World *world, int i) {
+    CoinStore *c = &world->coins;
+    array_erase(c->x, sizeof(int), i, c->count); array_erase(c->y, sizeof(int), i, c->count);
+    array_erase(c->w, sizeof(int), i, c->count); array_erase(c->h, sizeof(int), i, c->count);
+    c->count--;
+}
+void remove_enemy(World *world, int i) {
+    EnemyStore *e = &world->enemies;
+    world->proxies_valid = 0;
+    array_erase(e->x, sizeof(int), i, e->count); array_erase(e->y, sizeof(int), i, e->count);
+    array_erase(e->w, sizeof(int), i, e->count); array_erase(e->h, sizeof(int), i, e->count);
+    array_erase(e->dir, sizeof(int), i, e->count); array_erase(e->speed, sizeof(float), i, e->count);
+    array_erase(e->fx, sizeof(float), i, e->count); array_erase(e->prev_x, sizeof(float), i, e->count);
+    e->count--;
+}
+void remove_mush(World *world, int i) {
+    MushStore *m = &world->mush;
+    world->proxies_valid = 0;
+    array_erase(m->x, sizeof(int), i, m->count); array_erase(m->y, sizeof(int), i, m->count);
+    array_erase(m->w, sizeof(int), i, m->count); array_erase(m->h, sizeof(int), i, m->count);
+    m->count--;
 }
 
-void draw_flag(SDL_Renderer *ren, SDL_Rect flag, int camx) {
-    SDL_Rect fr = flag;
-    fr.x -= camx;
-    /* pole */
-    draw_rect(ren, fr.x + fr.w/2 - 2, fr.y + fr.h - 4*TILE, 4, 4*TILE, (SDL_Color){220,220,220,255});
-    /* flag */
-    SDL_Point pts[3] = {{fr.x + fr.w/2 + 4, fr.y + fr.h - 4*TILE + 30}, {fr.x + fr.w/2 + 38, fr.y + fr.h - 4*TILE + 18}, {fr.x + fr.w/2 + 38, fr.y + fr.h - 4*TILE + 42}};
-    /* draw as filled triangle using rects (simple) */
-    draw_rect(ren, pts[0].x, pts[0].y, 34, 24, FLAG_COL);
+/* first index in the sorted x[0..count) with x >= v */
+int lower_x(const int *x, int count, int v) {
+    int lo = 0, hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (x[mid] < v) lo = mid + 1; else hi = mid;
+    }
+    return lo;
 }
 
-/* ---------------- GAME INIT / START ---------------- */
-void start_level(int idx, Player *pl, int *level_time, Uint32 *t0) {
-    build_level(LEVELS[idx], 8);
-    /* spawn player at left safe position */
-    int spawnx = 60;
-    int spawny = 0;
-    SDL_FRect temp = {.x = (float)spawnx, .y = (float)spawny, .w = TILE-12, .h = TILE-8};
-    float vy = 0;
-    /* drop until hitting ground */
-    for (int iter=0; iter<2000; iter++){
-        vy += 1.0f;
-        temp.y += vy;
-        SDL_Rect test = {(int)roundf(temp.x),(int)roundf(temp.y),(int)roundf(temp.w),(int)roundf(temp.h)};
-        int hit = 0;
-        for (int s=0;s<solids_count;s++){
-            if (aabb_int(test, solids[s])) { hit = 1; break; }
-        }
-        if (hit) {
-            /* snap above */
-            for (int s=0;s<solids_count;s++){
-                if (aabb_int(test, solids[s])) {
-                    temp.y = solids[s].y - temp.h;
-                    break;
+/* [*lo, *hi): the entities of a sorted store that can overlap x in
+   [x0, x1); no entity is wider than a tile */
+void store_span(const int *x, int count, int x0, int x1, int *lo, int *hi) {
+    *lo = lower_x(x, count, x0 - TILE);
+    *hi = lower_x(x, count, x1);
+}
+
+/* Spawns arrive in map order; level_end sorts each store by x (stable,
+   so entities in one column keep map order). */
+typedef struct { int x, idx; } SortKey;
+
+int sort_key_cmp(const void *pa, const void *pb) {
+    const SortKey *a = pa, *b = pb;
+    if (a->x != b->x) return a->x < b->x ? -1 : 1;
+    return a->idx - b->idx;
+}
+
+/* reorder a[0..n) so a[i] = old a[keys[i].idx]; tmp holds n elements */
+void array_gather(void *a, size_t elem, const SortKey *keys, int n, void *tmp) {
+    for (int i=0;i<n;i++) memcpy((char *)tmp + i * elem, (char *)a + keys[i].idx * elem, elem);
+    memcpy(a, tmp, n * elem);
+}
+
+void sort_store(int **ints, int nints, float **floats, int nfloats, int n) {
+    if (n < 2) return;
+    SortKey *keys = malloc(n * sizeof(SortKey));
+    void *tmp = malloc(n * sizeof(double));   /* room for n ints or n floats */
+    if (!keys || !tmp) { fprintf(stderr, "out of memory\n"); exit(1); }
+    for (int i=0;i<n;i++) keys[i] = (SortKey){ints[0][i], i};   /* ints[0] is x */
+    qsort(keys, n, sizeof(SortKey), sort_key_cmp);
+    for (int k=0;k<nints;k++) array_gather(ints[k], sizeof(int), keys, n, tmp);
+    for (int k=0;k<nfloats;k++) array_gather(floats[k], sizeof(float), keys, n, tmp);
+    free(keys);
+    free(tmp);
+}
+
+/* Build-time tile merging: when on, runs and blocks of same-kind tiles
+   become one solid rect (full blocks merge in both directions, 't' caps
+   along their row), which shrinks solids[] by an order of magnitude.
+   Collision answers are unchanged since
+   queries still resolve against the individual cell (see solid_hit). */
+int merge_solids = 1;   /* --no-merge turns it off */
+
+/* Tile kinds to turn into solids: the whole map, or one column chunk of
+   a paged level whose first column is map column col0. grid gets each
+   cell's index into out[] and must start all -1. */
+typedef struct {
+    const unsigned char *kind;  /* row-major, cols per row */
+    int *grid;
+    int cols, rows, col0;
+    SDL_Rect *out;
+    int count, cap;
+} SolidBlock;
+
+/* add one solid covering the block's cols [col, col+w) x rows [row, row+h) */
+void grid_add_solid(SolidBlock *b, int col, int row, int w, int h, int kind) {
+    if (b->count >= b->cap) return;
+    for (int j=row;j<row+h;j++){
+        for (int i=col;i<col+w;i++) b->grid[j*b->cols + i] = b->count;
+    }
+    int x = (b->col0 + col) * TILE;
+    if (kind == TILE_CAP)
+        b->out[b->count++] = (SDL_Rect){x, row*TILE + TILE/2, w*TILE, TILE/2};
+    else
+        b->out[b->count++] = (SDL_Rect){x, row*TILE, w*TILE, h*TILE};
+}
+
+/* emit the block's solids row-major, so out[] keeps map order */
+void emit_solids(SolidBlock *b) {
+    for (int j=0;j<b->rows;j++){
+        for (int i=0;i<b->cols;i++){
+            int kind = b->kind[j*b->cols + i];
+            if (kind == TILE_EMPTY || b->grid[j*b->cols + i] >= 0) continue;
+            int w = 1, h = 1;
+            if (merge_solids) {
+                while (i + w < b->cols && b->kind[j*b->cols + i+w] == kind && b->grid[j*b->cols + i+w] < 0) w++;
+                /* caps are half-height, so only full blocks stack */
+                while (kind == TILE_FULL && j + h < b->rows) {
+                    int ok = 1;
+                    for (int k=i;k<i+w && ok;k++) ok = b->kind[(j+h)*b->cols + k] == kind && b->grid[(j+h)*b->cols + k] < 0;
+                    if (!ok) break;
+                    h++;
                 }
             }
-            break;
+            grid_add_solid(b, i, j, w, h, kind);
         }
     }
-    pl->r.x = temp.x; pl->r.y = temp.y; pl->r.w = temp.w; pl->r.h = temp.h;
-    pl->vx = pl->vy = 0;
-    pl->spawn.x = pl->r.x; pl->spawn.y = pl->r.y;
-    *level_time = 300;
-    *t0 = SDL_GetTicks();
 }
 
-/* ---------------- MAIN ---------------- */
-int main(int argc, char **argv) {
-    (void)argc; (void)argv;
-    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
-        fprintf(stderr, "SDL Init error: %s\n", SDL_GetError()); return 1;
-    }
-    if (TTF_Init() != 0) {
-        fprintf(stderr, "TTF Init error: %s\n", TTF_GetError()); SDL_Quit(); return 1;
+void build_solids(World *world) {
+    SolidBlock b = {world->tile_kind, world->solid_grid, world->grid_cols, world->grid_rows, 0, world->solids, 0, world->solids_cap};
+    emit_solids(&b);
+    world->solids_count = b.count;
+}
+
+/* Level construction is split so text maps and binary level files share it:
+   the caller counts the level's contents into a LevelSize, level_begin
+   lays out the arena for exactly that, the caller fills tile_kind and
+   calls level_spawn for each entity, and level_end finishes it. */
+enum {SPAWN_COIN, SPAWN_ENEMY, SPAWN_MUSH, SPAWN_GOAL, SPAWN_KINDS};
+
+typedef struct {
+    int cols, rows;         /* tile grid */
+    int world_cols;         /* scrollable width in tiles */
+    int tiles;              /* non-empty cells, an upper bound on solids */
+    int spawns[SPAWN_KINDS];
+    int paged;              /* grid read from World.file_tiles (see TILE PAGES) */
+} LevelSize;
+
+/* pages a paged level keeps: every chunk tile_pages_window can ask for
+   (the active region and a chunk beyond each side, at any alignment),
+   plus one for the renderer baking ahead; the whole level when it is that
+   short or runs without an active region */
+int tile_page_count(int cols) {
+    int chunks = (cols + CHUNK_TILES - 1) / CHUNK_TILES;
+    if (sim_margin < 0) return chunks;
+    int n = (SCREEN_W + 2 * sim_margin * TILE + 2 * CHUNK_W) / CHUNK_W + 3;
+    return n < chunks ? n : chunks;
+}
+
+size_t tile_pages_size(int cols, int rows) {
+    int chunks = (cols + CHUNK_TILES - 1) / CHUNK_TILES, n = tile_page_count(cols);
+    size_t page_cells = (size_t)CHUNK_TILES * rows;
+    return arena_size(sizeof(TilePages)) + arena_size(n * sizeof(TilePage)) + arena_size(chunks * sizeof(int))
+         + arena_size(page_cells * sizeof(int)) + n * (arena_size(page_cells) + arena_size(page_cells * sizeof(SDL_Rect)));
+}
+
+TilePages *tile_pages_alloc(Arena *a, int cols, int rows) {
+    size_t page_cells = (size_t)CHUNK_TILES * rows;
+    TilePages *tp = arena_alloc(a, sizeof(TilePages));
+    tp->count = tile_page_count(cols);
+    tp->chunks = (cols + CHUNK_TILES - 1) / CHUNK_TILES;
+    tp->clock = 0;
+    tp->page_ins = 0;
+    tp->page = arena_alloc(a, tp->count * sizeof(TilePage));
+    tp->page_of = arena_alloc(a, tp->chunks * sizeof(int));
+    tp->scratch = arena_alloc(a, page_cells * sizeof(int));
+    memset(tp->page_of, 0xff, tp->chunks * sizeof(int));   /* all -1 */
+    for (int k=0;k<tp->count;k++){
+        TilePage *p = &tp->page[k];
+        p->chunk = -1;
+        p->last_used = 0;
+        p->kind = arena_alloc(a, page_cells);
+        p->solids = arena_alloc(a, page_cells * sizeof(SDL_Rect));
+        p->solids_count = 0;
     }
+    return tp;
+}
 
-    SDL_Window *win = SDL_CreateWindow("Retro Platformer (C / SDL2)", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_W, SCREEN_H, 0);
-    if (!win) { fprintf(stderr, "CreateWindow failed: %s\n", SDL_GetError()); TTF_Quit(); SDL_Quit(); return 1; }
-    SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-    if (!ren) { fprintf(stderr, "CreateRenderer failed: %s\n", SDL_GetError()); SDL_DestroyWindow(win); TTF_Quit(); SDL_Quit(); return 1; }
+SDL_atomic_t level_builds;   /* level_begin calls so far, in every World */
 
-    TTF_Font *font = TTF_OpenFont("/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf", 18);
-    if (!font) {
-        /* try fallback to bundled font path on some Windows setups; if missing, we will continue without text */
-        font = NULL;
+void level_begin(World *world, const LevelSize *ls) {
+    /* a paged level keeps its pages instead of the whole-level grid */
+    size_t cells = ls->paged ? 0 : (size_t)ls->cols * ls->rows;
+    int tiles = ls->paged ? 0 : ls->tiles;
+    int nc = ls->spawns[SPAWN_COIN], ne = ls->spawns[SPAWN_ENEMY], nm = ls->spawns[SPAWN_MUSH];
+    /* entity stores and their broadphase proxies first, so everything a tick
+       can change is the contiguous span [base, base + level_state_bytes) */
+    size_t need = 4 * arena_size(nc * sizeof(int))
+                + 5 * arena_size(ne * sizeof(int)) + 3 * arena_size(ne * sizeof(float))
+                + 4 * arena_size(nm * sizeof(int))
+                + arena_size(tiles * sizeof(SDL_Rect))
+                + arena_size(cells * sizeof(int)) + arena_size(cells)
+                + arena_size((ne + nm) * sizeof(Proxy))
+                + (ls->paged ? tile_pages_size(ls->cols, ls->rows) : 0);
+    /* the previous level's file, if it was paged */
+    if (world->file.data) file_view_close(&world->file);
+    world->file_tiles = NULL;
+    if (!arena_reset(&world->arena, need)) {
+        fprintf(stderr, "out of memory for a %dx%d level\n", ls->cols, ls->rows);
+        exit(1);
     }
+    Arena *a = &world->arena;
+    world->coins.count = 0; world->coins.cap = nc;
+    world->coins.x = arena_alloc(a, nc * sizeof(int)); world->coins.y = arena_alloc(a, nc * sizeof(int));
+    world->coins.w = arena_alloc(a, nc * sizeof(int)); world->coins.h = arena_alloc(a, nc * sizeof(int));
+    world->enemies.count = 0; world->enemies.cap = ne;
+    world->enemies.x = arena_alloc(a, ne * sizeof(int)); world->enemies.y = arena_alloc(a, ne * sizeof(int));
+    world->enemies.w = arena_alloc(a, ne * sizeof(int)); world->enemies.h = arena_alloc(a, ne * sizeof(int));
+    world->enemies.dir = arena_alloc(a, ne * sizeof(int)); world->enemies.speed = arena_alloc(a, ne * sizeof(float));
+    world->enemies.fx = arena_alloc(a, ne * sizeof(float)); world->enemies.prev_x = arena_alloc(a, ne * sizeof(float));
+    world->mush.count = 0; world->mush.cap = nm;
+    world->mush.x = arena_alloc(a, nm * sizeof(int)); world->mush.y = arena_alloc(a, nm * sizeof(int));
+    world->mush.w = arena_alloc(a, nm * sizeof(int)); world->mush.h = arena_alloc(a, nm * sizeof(int));
+    world->proxies = arena_alloc(a, (ne + nm) * sizeof(Proxy));
+    world->proxy_count = 0;
+    world->proxies_valid = 0;
+    world->state_bytes = a->used;
+    world->solids_count = 0; world->solids_cap = tiles;
+    world->solids = arena_alloc(a, tiles * sizeof(SDL_Rect));
+    world->solid_grid = arena_alloc(a, cells * sizeof(int));
+    world->tile_kind = arena_alloc(a, cells);
+    memset(world->solid_grid, 0xff, cells * sizeof(int));   /* all -1 */
+    memset(world->tile_kind, TILE_EMPTY, cells);
+    world->pages = ls->paged ? tile_pages_alloc(a, ls->cols, ls->rows) : NULL;
+    world->goal_exists = 0;
+    world->player_start_known = 0;
+    /* unique across Worlds: start_level may swap in a World built elsewhere */
+    world->level_serial = SDL_AtomicIncRef(&level_builds) + 1;
+    world->width = ls->world_cols * TILE;
+    world->grid_rows = ls->rows;
+    world->grid_cols = ls->cols;
+}
 
-    /* game state */
-    enum {STATE_TITLE, STATE_PLAY, STATE_LEVEL_CLEAR, STATE_GAME_OVER, STATE_WIN} state = STATE_TITLE;
-    int level_idx = 0;
-    Player player = {0};
-    player.coins = 0; player.score = 0; player.lives = 3; player.big = 0; player.big_timer = 0;
-    player.r.w = TILE-12; player.r.h = TILE-8;
-    int level_time = 300;
-    Uint32 t0 = 0;
+void level_spawn(World *world, int kind, int col, int row) {
+    int x = col*TILE;
+    int y = row*TILE;
+    if (kind == SPAWN_COIN) {
+        add_coin(world, (SDL_Rect){x+TILE/4, y+TILE/4, TILE/2, TILE/2});
+    } else if (kind == SPAWN_ENEMY) {
+        add_enemy(world, (SDL_Rect){x+6,y+8,TILE-12,TILE-16}, -1, 1.0f);
+    } else if (kind == SPAWN_MUSH) {
+        add_mush(world, (SDL_Rect){x+12,y+12,TILE-24,TILE-24});
+    } else if (kind == SPAWN_GOAL) {
+        world->goal_rect = (SDL_Rect){x+TILE/2-6,y-4*TILE,12,4*TILE};
+        world->goal_exists = 1;
+    }
+}
 
-    start_level(level_idx, &player, &level_time, &t0);
+/* after the last level_spawn: solids from the tile grid (paged levels
+   build theirs per chunk), stores in x order */
+void level_end(World *world) {
+    if (!world->pages) build_solids(world);
+    CoinStore *c = &world->coins;
+    EnemyStore *e = &world->enemies;
+    MushStore *m = &world->mush;
+    int *ci[] = {c->x, c->y, c->w, c->h};
+    int *ei[] = {e->x, e->y, e->w, e->h, e->dir};
+    float *ef[] = {e->speed, e->fx, e->prev_x};
+    int *mi[] = {m->x, m->y, m->w, m->h};
+    sort_store(ci, 4, NULL, 0, c->count);
+    sort_store(ei, 5, ef, 3, e->count);
+    sort_store(mi, 4, NULL, 0, m->count);
+}
 
-    int running = 1;
-    Uint32 last_tick = SDL_GetTicks();
+/* map character -> spawn kind, or -1 */
+int spawn_of_char(char ch) {
+    switch (ch) {
+        case 'C': return SPAWN_COIN;
+        case 'E': return SPAWN_ENEMY;
+        case 'M': return SPAWN_MUSH;
+        case 'F': return SPAWN_GOAL;
+        default: return -1;
+    }
+}
 
-    while (running) {
-        Uint32 now = SDL_GetTicks();
-        float dt = (now - last_tick) / 1000.0f;
-        if (dt < 1.0f / FPS) {
-            SDL_Delay((Uint32)((1.0f/FPS - dt)*1000));
-            now = SDL_GetTicks();
-            dt = (now - last_tick) / 1000.0f;
-        }
-        last_tick = now;
+/* map character -> TILE_* */
+int tile_of_char(char ch) {
+    if (ch=='X' || ch=='=') return TILE_FULL;
+    if (ch=='t') return TILE_CAP;
+    return TILE_EMPTY;
+}
 
-        SDL_Event ev;
-        while (SDL_PollEvent(&ev)) {
-            if (ev.type == SDL_QUIT) { running = 0; }
-            else if (ev.type == SDL_KEYDOWN) {
-                SDL_Keycode k = ev.key.keysym.sym;
-                if (k == SDLK_ESCAPE) { running = 0; }
-                if (state == STATE_TITLE && k == SDLK_RETURN) {
-                    state = STATE_PLAY;
-                    level_idx = 0;
-                    player.score = player.coins = 0;
-                    player.lives = 3;
-                    start_level(level_idx, &player, &level_time, &t0);
-                } else if (state == STATE_LEVEL_CLEAR && k == SDLK_RETURN) {
-                    level_idx++;
-                    if (level_idx >= NUM_LEVELS) {
-                        state = STATE_WIN;
-                    } else {
-                        start_level(level_idx, &player, &level_time, &t0);
-                        state = STATE_PLAY;
-                    }
-                } else if (state == STATE_GAME_OVER && k == SDLK_RETURN) {
-                    /* restart */
-                    state = STATE_PLAY;
-                    level_idx = 0; player.score = 0; player.coins = 0; player.lives = 3;
-                    start_level(level_idx, &player, &level_time, &t0);
-                } else if (k == SDLK_r) {
-                    start_level(level_idx, &player, &level_time, &t0);
-                } else if (k == SDLK_z || k == SDLK_SPACE || k == SDLK_UP) {
-                    if (state == STATE_PLAY) {
-                        if (player.on_ground) player.vy = JUMP_VEL * (player.big ? 0.95f : 1.0f);
-                    }
-                }
+void build_level(World *world, const char *map_lines[], int rows) {
+    int *lens = malloc((rows > 0 ? rows : 1) * sizeof(int));
+    if (!lens) { fprintf(stderr, "out of memory\n"); exit(1); }
+    LevelSize ls = {0};
+    ls.rows = rows;
+    for (int j=0;j<rows;j++){
+        const char *row = map_lines[j];
+        lens[j] = (int)strlen(row);
+        if (lens[j] > ls.cols) ls.cols = lens[j];
+        for (int i=0;i<lens[j];i++){
+            int kind;
+            if (tile_of_char(row[i]) != TILE_EMPTY) ls.tiles++;
+            else if ((kind = spawn_of_char(row[i])) >= 0) ls.spawns[kind]++;
+        }
+    }
+    ls.world_cols = rows > 0 ? lens[0] : 0;
+    level_begin(world, &ls);
+    for (int j=0;j<rows;j++){
+        const char *row = map_lines[j];
+        for (int i=0;i<lens[j];i++){
+            char ch = row[i];
+            int kind = tile_of_char(ch);
+            if (kind != TILE_EMPTY) {
+                world->tile_kind[j*world->grid_cols + i] = (unsigned char)kind;
+            } else if ((kind = spawn_of_char(ch)) >= 0) {
+                level_spawn(world, kind, i, j);
             }
         }
+    }
+    free(lens);
+    level_end(world);
+}
 
-        const Uint8 *keystate = SDL_GetKeyboardState(NULL);
-        if (state == STATE_PLAY) {
-            /* input horizontal */
-            float ax = 0;
-            if (keystate[SDL_SCANCODE_LEFT] || keystate[SDL_SCANCODE_A]) ax -= 0.9f;
-            if (keystate[SDL_SCANCODE_RIGHT] || keystate[SDL_SCANCODE_D]) ax += 0.9f;
-            player.vx += ax;
-            if (player.vx > MAX_XSPEED) player.vx = MAX_XSPEED;
-            if (player.vx < -MAX_XSPEED) player.vx = -MAX_XSPEED;
-            /* gravity */
-            player.vy += GRAVITY;
-            if (player.vy > 20) player.vy = 20;
-            /* collisions */
-            resolve_horz_collision(&player);
-            resolve_vert_collision(&player);
-            /* friction */
-            if (player.on_ground && fabsf(player.vx) > 0.01f) { player.vx *= 0.82f; if (fabsf(player.vx) < 0.1f) player.vx = 0; }
-
-            /* coins */
-            for (int i=0;i<coin_count;i++){
-                if (!coins[i].active) continue;
-                SDL_Rect pr = {(int)roundf(player.r.x),(int)roundf(player.r.y),(int)roundf(player.r.w),(int)roundf(player.r.h)};
-                if (aabb_int(pr, coins[i].r)) {
-                    coins[i].active = 0;
-                    player.coins++;
-                    player.score += 100;
-                }
-            }
-            /* mushrooms */
-            for (int i=0;i<mush_count;i++){
-                if (!mush[i].active) continue;
-                SDL_Rect pr = {(int)roundf(player.r.x),(int)roundf(player.r.y),(int)roundf(player.r.w),(int)roundf(player.r.h)};
-                if (aabb_int(pr, mush[i].r)) {
-                    mush[i].active = 0;
-                    if (!player.big) {
-                        /* grow */
-                        player.big = 1;
-                        player.r.h += TILE/2;
-                        player.r.y -= TILE/2;
-                        player.big_timer = 12.0f;
-                        player.score += 500;
-                    } else {
-                        /* already big -> give points */
-                        player.score += 200;
-                    }
-                }
-            }
-            /* enemies update */
-            update_enemies(dt);
-            /* interactions with enemies */
-            for (int i=0;i<enemy_count;i++){
-                if (!enemies[i].active) continue;
-                SDL_Rect er = enemies[i].r;
-                SDL_Rect pr = {(int)roundf(player.r.x),(int)roundf(player.r.y),(int)roundf(player.r.w),(int)roundf(player.r.h)};
-                if (aabb_int(pr, er)) {
-                    /* stomp if falling and near top */
-                    if (player.vy > 0 && (player.r.y + player.r.h) - er.y < 16.0f) {
-                        enemies[i].active = 0;
-                        player.vy = JUMP_VEL * 0.6f;
-                        player.score += 200;
-                    } else {
-                        if (player.big) {
-                            /* shrink */
-                            player.big = 0;
-                            player.r.h -= TILE/2;
-                            player.r.y += TILE/2;
-                        } else {
-                            /* lose life and respawn */
-                            player.lives--;
-                            player.r.x = player.spawn.x;
-                            player.r.y = player.spawn.y;
-                            player.vx = player.vy = 0;
-                            if (player.lives <= 0) state = STATE_GAME_OVER;
-                        }
-                    }
-                }
-            }
-            /* fall off screen */
-            if (player.r.y > SCREEN_H + 200) {
-                player.lives--;
-                player.r.x = player.spawn.x;
-                player.r.y = player.spawn.y;
-                player.vx = player.vy = 0;
-                if (player.lives <= 0) state = STATE_GAME_OVER;
-            }
-            /* check flag / goal */
-            if (goal_exists) {
-                SDL_Rect pr = {(int)roundf(player.r.x),(int)roundf(player.r.y),(int)roundf(player.r.w),(int)roundf(player.r.h)};
-                SDL_Rect gr = goal_rect;
-                if (aabb_int(pr, gr)) {
-                    state = STATE_LEVEL_CLEAR;
-                }
-            }
-            /* big timer */
-            if (player.big) {
-                player.big_timer -= 1.0f / FPS;
-                if (player.big_timer <= 0) {
-                    player.big = 0;
-                    player.r.h -= TILE/2;
-                    player.r.y += TILE/2;
-                }
-            }
-            /* level timer */
-            int time_left = level_time - (int)((SDL_GetTicks() - t0) / 1000);
-            if (time_left <= 0) {
-                /* out of time: lose a life and reset level start time */
-                player.lives--;
-                player.r.x = player.spawn.x;
-                player.r.y = player.spawn.y;
-                player.vx = player.vy = 0;
-                t0 = SDL_GetTicks();
-                if (player.lives <= 0) state = STATE_GAME_OVER;
-            }
-        } /* end STATE_PLAY handling */
+/* ---------------- LEVEL FILES ----------------
+   Text maps (.txt) use the LEVELS legend, one map row per line.
+   Binary levels (.lvl) are what --compile-level writes: a header, the tile
+   grid as one TILE_* byte per cell, row-major, and a spawn table in map
+   order. All fields are little-endian. The file is mmap'd and validated
+   once. A level longer than the active region stays mapped while it is
+   played and its grid is paged in a chunk at a time (see TILE PAGES), so
+   that grid is never all in memory at once; a shorter one, or any level
+   with --sim-margin -1, is copied straight into tile_kind and unmapped. */
+typedef struct {
+    char magic[4];          /* "RPLV" */
+    Uint32 version;         /* LEVEL_FILE_VERSION */
+    Uint32 cols, rows;      /* tile grid size */
+    Uint32 world_cols;      /* scrollable width in tiles (length of row 0) */
+    Uint32 tiles_offset;    /* byte offset of the cols*rows tile grid */
+    Uint32 spawn_count;
+    Uint32 spawns_offset;   /* byte offset of spawn_count LevelSpawn */
+} LevelFileHeader;
 
-        /* render */
-        SDL_SetRenderDrawColor(ren, SKY.r, SKY.g, SKY.b, SKY.a);
-        SDL_RenderClear(ren);
+typedef struct {
+    Uint16 kind;            /* SPAWN_* */
+    Uint16 col, row;
+    Uint16 pad;
+} LevelSpawn;
 
-        if (state == STATE_TITLE) {
-            /* simple title screen */
-            draw_rect(ren, 180, 100, 600, 80, (SDL_Color){255,255,255,255});
-            if (font) {
-                SDL_Surface *s = TTF_RenderText_Blended(font, "RETRO PLATFORMER (C / SDL2) - Press Enter to Start", HUD_COL);
-                if (s) {
-                    SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                    int w,h; SDL_QueryTexture(tx, NULL, NULL, &w, &h);
-                    SDL_Rect dst = { (SCREEN_W-w)/2, 240, w, h };
-                    SDL_RenderCopy(ren, tx, NULL, &dst);
-                    SDL_DestroyTexture(tx);
-                    SDL_FreeSurface(s);
-                }
-            }
-        } else if (state == STATE_PLAY || state == STATE_LEVEL_CLEAR || state == STATE_GAME_OVER || state == STATE_WIN) {
-            /* camera */
-            int camx = (int)(player.r.x + player.r.w/2) - SCREEN_W/2;
-            if (camx < 0) camx = 0;
-            if (camx > world_width - SCREEN_W) camx = world_width - SCREEN_W;
-            /* background hills */
-            for (int i=-2;i<12;i++){
-                int bx = i*300 - (camx/2 % 600);
-                SDL_SetRenderDrawColor(ren, 70,160,90,255);
-                SDL_Rect hill = {bx, SCREEN_H-80, 220, 80};
-                SDL_RenderFillRect(ren, &hill);
-            }
-            /* draw level tiles */
-            draw_level(ren, camx);
-            /* draw coins */
-            for (int i=0;i<coin_count;i++){
-                if (coins[i].active) draw_coin(ren, &coins[i], camx);
-            }
-            /* mushrooms */
-            for (int i=0;i<mush_count;i++){
-                if (mush[i].active) draw_mush(ren, &mush[i], camx);
-            }
-            /* enemies */
-            for (int i=0;i<enemy_count;i++){
-                if (enemies[i].active) draw_enemy(ren, &enemies[i], camx);
-            }
-            /* flag */
-            if (goal_exists) draw_flag(ren, goal_rect, camx);
-            /* player */
-            draw_player(ren, &player, camx);
+#define LEVEL_FILE_VERSION 1
 
-            /* HUD */
-            if (font) {
-                char buf[256];
-                int time_left = level_time - (int)((SDL_GetTicks() - t0) / 1000);
-                snprintf(buf, sizeof(buf), "LEVEL %d    SCORE %06d    COINS %02d    LIVES %d    TIME %03d",
-                         level_idx+1, player.score, player.coins, player.lives, time_left);
-                SDL_Surface *s = TTF_RenderText_Blended(font, buf, HUD_COL);
-                if (s) {
-                    SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                    SDL_Rect dst = {12, 10, s->w, s->h};
-                    SDL_RenderCopy(ren, tx, NULL, &dst);
-                    SDL_DestroyTexture(tx);
-                    SDL_FreeSurface(s);
-                }
-            }
-            /* small message if big */
-            if (player.big && font) {
-                SDL_Surface *s = TTF_RenderText_Blended(font, "MUSHROOM: BIG!", (SDL_Color){10,10,10,255});
-                if (s) {
-                    SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                    SDL_Rect dst = {SCREEN_W - s->w - 12, 10, s->w, s->h};
-                    SDL_RenderCopy(ren, tx, NULL, &dst);
-                    SDL_DestroyTexture(tx);
-                    SDL_FreeSurface(s);
-                }
-            }
+/* if the level is paged, data must stay valid while it is played (load_level
+   then hands the World its FileView) */
+int build_level_bin(World *world, const unsigned char *data, size_t size) {
+    LevelFileHeader h;
+    if (size < sizeof(h)) return 0;
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, "RPLV", 4) != 0 || SDL_SwapLE32(h.version) != LEVEL_FILE_VERSION) return 0;
+    Uint32 cols = SDL_SwapLE32(h.cols), rows = SDL_SwapLE32(h.rows);
+    Uint32 tiles = SDL_SwapLE32(h.tiles_offset);
+    Uint32 nspawn = SDL_SwapLE32(h.spawn_count), spawns = SDL_SwapLE32(h.spawns_offset);
+    if (cols > 65535 || rows > 65535 || tiles > size || (size_t)cols * rows > size - tiles) return 0;
+    if (spawns > size || (size_t)nspawn * sizeof(LevelSpawn) > size - spawns) return 0;
+    if (SDL_SwapLE32(h.world_cols) > cols) return 0;
+    const unsigned char *grid = data + tiles;
+    /* spawns_offset need not be aligned in the mapping: copy each one out */
+    const unsigned char *sp = data + spawns;
+    LevelSize ls = {0};
+    ls.cols = (int)cols; ls.rows = (int)rows;
+    ls.world_cols = (int)SDL_SwapLE32(h.world_cols);
+    /* page the grid unless the level would keep every chunk anyway */
+    ls.paged = tile_page_count(ls.cols) < (ls.cols + CHUNK_TILES - 1) / CHUNK_TILES;
+    for (size_t i=0;i<(size_t)cols * rows;i++){
+        if (grid[i] > TILE_CAP) return 0;
+        ls.tiles += grid[i] != TILE_EMPTY;
+    }
+    for (Uint32 i=0;i<nspawn;i++){
+        LevelSpawn s;
+        memcpy(&s, sp + i * sizeof(s), sizeof(s));
+        Uint16 kind = SDL_SwapLE16(s.kind);
+        if (kind >= SPAWN_KINDS || SDL_SwapLE16(s.col) >= cols || SDL_SwapLE16(s.row) >= rows) return 0;
+        ls.spawns[kind]++;
+    }
+    level_begin(world, &ls);
+    if (ls.paged) world->file_tiles = grid;
+    else memcpy(world->tile_kind, grid, (size_t)cols * rows);
+    for (Uint32 i=0;i<nspawn;i++){
+        LevelSpawn s;
+        memcpy(&s, sp + i * sizeof(s), sizeof(s));
+        level_spawn(world, SDL_SwapLE16(s.kind), SDL_SwapLE16(s.col), SDL_SwapLE16(s.row));
+    }
+    level_end(world);
+    return 1;
+}
 
-            if (state == STATE_LEVEL_CLEAR) {
-                if (font) {
-                    SDL_Surface *s = TTF_RenderText_Blended(font, "COURSE CLEAR! Press Enter to continue", (SDL_Color){255,255,255,255});
-                    if (s) {
-                        SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                        SDL_Rect dst = {(SCREEN_W - s->w)/2, SCREEN_H/3, s->w, s->h};
-                        SDL_RenderCopy(ren, tx, NULL, &dst);
-                        SDL_DestroyTexture(tx);
-                        SDL_FreeSurface(s);
-                    }
-                }
-            } else if (state == STATE_GAME_OVER) {
-                if (font) {
-                    SDL_Surface *s = TTF_RenderText_Blended(font, "GAME OVER - Press Enter to Restart", (SDL_Color){255,255,255,255});
-                    if (s) {
-                        SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                        SDL_Rect dst = {(SCREEN_W - s->w)/2, SCREEN_H/3, s->w, s->h};
-                        SDL_RenderCopy(ren, tx, NULL, &dst);
-                        SDL_DestroyTexture(tx);
-                        SDL_FreeSurface(s);
-                    }
-                }
-            } else if (state == STATE_WIN) {
-                if (font) {
-                    SDL_Surface *s = TTF_RenderText_Blended(font, "YOU WIN! Thanks for playing", (SDL_Color){255,255,255,255});
-                    if (s) {
-                        SDL_Texture *tx = SDL_CreateTextureFromSurface(ren, s);
-                        SDL_Rect dst = {(SCREEN_W - s->w)/2, SCREEN_H/3, s->w, s->h};
-                        SDL_RenderCopy(ren, tx, NULL, &dst);
-                        SDL_DestroyTexture(tx);
-                        SDL_FreeSurface(s);
-                    }
-                }
-            }
-        }
+/* split text in place into lines; *rows_out is malloc'd, returns the count */
+int split_map_rows(char *text, const char ***rows_out) {
+    int max_rows = 1;
+    for (const char *c = text; *c; c++) max_rows += *c == '\n';
+    const char **rows = malloc(max_rows * sizeof(*rows));
+    *rows_out = rows;
+    if (!rows) return 0;
+    int n = 0;
+    char *p = text;
+    while (*p && n < max_rows) {
+        rows[n++] = p;
+        char *nl = strchr(p, '\n');
+        if (!nl) break;
+        if (nl > p && nl[-1] == '\r') nl[-1] = 0;
+        *nl = 0;
+        p = nl + 1;
+    }
+    if (n > 0) {
+        char *last = (char *)rows[n-1];
+        size_t len = strlen(last);
+        if (len > 0 && last[len-1] == '\r') last[len-1] = 0;
+    }
+    return n;
+}
 
-        SDL_RenderPresent(ren);
+/* NUL-terminated copy of a file, for text maps */
+char *load_text(const char *path) {
+    FileView v;
+    if (!file_view_open(&v, path)) return NULL;
+    char *text = malloc(v.size + 1);
+    if (text) { memcpy(text, v.data, v.size); text[v.size] = 0; }
+    file_view_close(&v);
+    return text;
+}
 
-        /* simple state advancement: go to WIN when level cleared and last level was done */
-        if (state == STATE_LEVEL_CLEAR) {
-            /* nothing automatic; waiting for Enter key to continue (handled in event loop) */
-        }
+int build_level_text_file(World *world, const char *path) {
+    char *text = load_text(path);
+    if (!text) return 0;
+    const char **rows;
+    int n = split_map_rows(text, &rows);
+    if (n > 0) build_level(world, rows, n);
+    free(rows);
+    free(text);
+    return n > 0;
+}
+
+/* DIR/levelNNN.EXT for 0-based idx */
+void level_path(char *out, size_t cap, int idx, const char *ext) {
+    snprintf(out, cap, "%s/level%03d.%s", level_dir, idx + 1, ext);
+}
+
+int file_exists(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+/* number of consecutive level files in level_dir */
+int count_level_files(void) {
+    char path[1024];
+    int n = 0;
+    for (;;) {
+        level_path(path, sizeof(path), n, "lvl");
+        if (!file_exists(path)) {
+            level_path(path, sizeof(path), n, "txt");
+            if (!file_exists(path)) break;
+        }
+        n++;
+    }
+    return n;
+}
+
+/* ---------------- BAKED LEVELS ----------------
+   The built-in maps, already built: baked_levels.h (written by
+   --bake-levels) holds each level's finished arrays exactly as build_level
+   leaves them in the arena, x-sorted and with the solids merged, plus the
+   player's start, so starting a built-in level is level_begin and a few
+   memcpys with no parsing or spawn search. The file carries a hash of
+   LEVELS, TILE and BAKE_VERSION; if it is missing or stale (or --no-merge
+   is on), the maps are parsed as before. The hash can't see code changes:
+   bump BAKE_VERSION whenever level_spawn, build_solids, level_end or
+   player_start change what a built level holds, and --check-baked compares
+   every baked level against a parsed build. */
+#define BAKE_VERSION 1
+
+typedef struct {
+    LevelSize size;
+    int coins, enemies, mush, solids;   /* counts */
+    /* coins x,y,w,h; enemies x,y,w,h,dir; mushrooms x,y,w,h (one array
+       per field, count long), then solids[] as rects and solid_grid */
+    const int *ints;
+    const float *floats;                /* enemies speed, fx, prev_x */
+    const unsigned char *tile_kind;
+    SDL_Rect goal_rect;
+    int goal_exists;
+    SDL_FPoint player_start;
+} BakedLevel;
+
+#if defined(__has_include)
+#if __has_include("baked_levels.h")
+#include "baked_levels.h"
+#endif
+#endif
+
+Uint64 fnv1a(Uint64 h, const void *data, size_t n) {
+    const unsigned char *p = data;
+    for (size_t i=0;i<n;i++){ h ^= p[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+/* what the baked tables were built from */
+Uint64 levels_hash(void) {
+    Uint64 h = 1469598103934665603ULL;
+    int consts[] = {TILE, BAKE_VERSION};
+    h = fnv1a(h, consts, sizeof(consts));
+    for (int l=0;l<NUM_LEVELS;l++)
+        for (int j=0;j<8;j++) h = fnv1a(h, LEVELS[l][j], strlen(LEVELS[l][j]) + 1);
+    return h;
+}
+
+/* baked tables for built-in level idx, or NULL */
+const BakedLevel *baked_level(int idx) {
+#ifdef BAKED_LEVELS_HASH
+    /* checked on first use; games may start levels from several threads
+       (see LIBRARY API), so the result is published atomically and only
+       the thread that publishes it warns */
+    static SDL_atomic_t state;   /* 0 unchecked, 1 usable, 2 stale */
+    int st = SDL_AtomicGet(&state);
+    if (st == 0) {
+        st = BAKED_LEVELS_HASH == levels_hash() && BAKED_LEVEL_COUNT == NUM_LEVELS ? 1 : 2;
+        if (SDL_AtomicCAS(&state, 0, st) && st == 2)
+            fprintf(stderr, "baked_levels.h is stale (regenerate with --bake-levels); parsing the built-in maps\n");
+    }
+    if (st == 1 && merge_solids && idx >= 0 && idx < BAKED_LEVEL_COUNT) return BAKED_LEVELS[idx];
+#else
+    (void)idx;
+#endif
+    return NULL;
+}
+
+void apply_baked(World *world, const BakedLevel *b) {
+    level_begin(world, &b->size);
+    CoinStore *c = &world->coins;
+    EnemyStore *e = &world->enemies;
+    MushStore *m = &world->mush;
+    int *ints[] = {c->x, c->y, c->w, c->h, e->x, e->y, e->w, e->h, e->dir, m->x, m->y, m->w, m->h};
+    int counts[] = {b->coins, b->coins, b->coins, b->coins, b->enemies, b->enemies, b->enemies, b->enemies, b->enemies, b->mush, b->mush, b->mush, b->mush};
+    const int *p = b->ints;
+    for (int k=0;k<13;k++){ memcpy(ints[k], p, counts[k] * sizeof(int)); p += counts[k]; }
+    memcpy(world->solids, p, b->solids * sizeof(SDL_Rect));
+    p += 4 * b->solids;
+    size_t cells = (size_t)b->size.cols * b->size.rows;
+    memcpy(world->solid_grid, p, cells * sizeof(int));
+    memcpy(world->tile_kind, b->tile_kind, cells);
+    float *floats[] = {e->speed, e->fx, e->prev_x};
+    for (int k=0;k<3;k++) memcpy(floats[k], b->floats + k * b->enemies, b->enemies * sizeof(float));
+    c->count = b->coins;
+    e->count = b->enemies;
+    m->count = b->mush;
+    world->solids_count = b->solids;
+    world->goal_rect = b->goal_rect;
+    world->goal_exists = b->goal_exists;
+    world->player_start = b->player_start;
+    world->player_start_known = 1;
+}
+
+void build_builtin_level(World *world, int idx) {
+    const BakedLevel *b = baked_level(idx);
+    if (b) apply_baked(world, b);
+    else build_level(world, LEVELS[idx], 8);
+}
+
+/* build level idx from the built-in maps or from level_dir */
+int load_level(World *world, int idx) {
+    if (!level_dir) {
+        build_builtin_level(world, idx);
+        return 1;
+    }
+    char path[1024];
+    level_path(path, sizeof(path), idx, "lvl");
+    FileView v;
+    if (file_view_open(&v, path)) {
+        if (build_level_bin(world, v.data, v.size)) {
+            /* a paged level reads it until the next level_begin or world_free */
+            if (world->pages) world->file = v;
+            else file_view_close(&v);
+            return 1;
+        }
+        file_view_close(&v);
+        fprintf(stderr, "bad level file %s\n", path);
+        return 0;
+    }
+    level_path(path, sizeof(path), idx, "txt");
+    if (build_level_text_file(world, path)) return 1;
+    fprintf(stderr, "cannot load level %s\n", path);
+    return 0;
+}
+
+/* text map -> binary level file */
+int compile_level(const char *in_path, const char *out_path) {
+    char *text = load_text(in_path);
+    if (!text) { fprintf(stderr, "cannot read %s\n", in_path); return 0; }
+    const char **rows;
+    int nrows = split_map_rows(text, &rows);
+    int cols = 0, nspawn = 0;
+    for (int j=0;j<nrows;j++){
+        int len = (int)strlen(rows[j]);
+        if (len > cols) cols = len;
+        for (int i=0;i<len;i++) if (spawn_of_char(rows[j][i]) >= 0) nspawn++;
+    }
+    if (cols > 65535 || nrows > 65535) {
+        fprintf(stderr, "%s: %dx%d tiles, max is 65535 each way\n", in_path, cols, nrows);
+        free(rows); free(text); return 0;
+    }
+    LevelFileHeader h = {{'R','P','L','V'}, 0, 0, 0, 0, 0, 0, 0};
+    h.version = SDL_SwapLE32(LEVEL_FILE_VERSION);
+    h.cols = SDL_SwapLE32((Uint32)cols);
+    h.rows = SDL_SwapLE32((Uint32)nrows);
+    h.world_cols = SDL_SwapLE32(nrows > 0 ? (Uint32)strlen(rows[0]) : 0);
+    h.tiles_offset = SDL_SwapLE32((Uint32)sizeof(h));
+    size_t spawns_at = (sizeof(h) + (size_t)cols * nrows + 3) & ~(size_t)3;
+    h.spawn_count = SDL_SwapLE32((Uint32)nspawn);
+    h.spawns_offset = SDL_SwapLE32((Uint32)spawns_at);
+    size_t size = spawns_at + (size_t)nspawn * sizeof(LevelSpawn);
+    unsigned char *out = calloc(1, size);
+    if (!out) { free(rows); free(text); return 0; }
+    memcpy(out, &h, sizeof(h));
+    LevelSpawn *sp = (LevelSpawn *)(out + spawns_at);
+    for (int j=0;j<nrows;j++){
+        int len = (int)strlen(rows[j]);
+        for (int i=0;i<len;i++){
+            char ch = rows[j][i];
+            out[sizeof(h) + (size_t)j * cols + i] = (unsigned char)tile_of_char(ch);
+            int kind = spawn_of_char(ch);
+            if (kind >= 0) {
+                sp->kind = SDL_SwapLE16((Uint16)kind);
+                sp->col = SDL_SwapLE16((Uint16)i);
+                sp->row = SDL_SwapLE16((Uint16)j);
+                sp++;
+            }
+        }
+    }
+    free(rows);
+    free(text);
+    FILE *f = fopen(out_path, "wb");
+    int ok = f && fwrite(out, 1, size, f) == size;
+    if (f && fclose(f) != 0) ok = 0;
+    free(out);
+    if (!ok) { fprintf(stderr, "cannot write %s\n", out_path); return 0; }
+    printf("%s: %dx%d tiles, %d spawns, %zu bytes\n", out_path, cols, nrows, nspawn, size);
+    return 1;
+}
+
+/* ---------------- TILE PAGES ----------------
+   A long .lvl level's grid is never copied whole: it is held as
+   CHUNK_TILES-wide column chunks paged in from the file's mapping. A page holds one chunk's
+   tile kinds in a compact block of its own, and that chunk's solids
+   (merged within the chunk) for the renderer. Every tick sim_tick asks
+   tile_pages_window for the active region plus a chunk either side, and
+   pages past it are evicted least recently used first; the page count is
+   fixed when the level is built (tile_page_count), so grid memory follows
+   the view and sim_margin, not the level length. The renderer pages in
+   the chunks it bakes the same way. Paging happens only on the thread
+   stepping the World and never inside parallel_for, so enemy jobs only
+   read pages; a cell outside every page is read straight from the file. */
+
+/* chunk c's page, copying the chunk in over the least recently used page */
+TilePage *tile_page(const World *world, int c) {
+    TilePages *tp = world->pages;
+    int slot = tp->page_of[c];
+    if (slot < 0) {
+        slot = 0;
+        for (int k=1;k<tp->count && tp->page[slot].chunk >= 0;k++){
+            if (tp->page[k].chunk < 0 || tp->page[k].last_used < tp->page[slot].last_used) slot = k;
+        }
+        TilePage *p = &tp->page[slot];
+        if (p->chunk >= 0) tp->page_of[p->chunk] = -1;
+        int col0 = c * CHUNK_TILES;
+        p->cols = world->grid_cols - col0 < CHUNK_TILES ? world->grid_cols - col0 : CHUNK_TILES;
+        for (int j=0;j<world->grid_rows;j++)
+            memcpy(p->kind + j*p->cols, world->file_tiles + (size_t)j*world->grid_cols + col0, p->cols);
+        memset(tp->scratch, 0xff, (size_t)p->cols * world->grid_rows * sizeof(int));
+        SolidBlock b = {p->kind, tp->scratch, p->cols, world->grid_rows, col0, p->solids, 0, p->cols * world->grid_rows};
+        emit_solids(&b);
+        p->solids_count = b.count;
+        p->chunk = c;
+        tp->page_of[c] = slot;
+        tp->page_ins++;
+    }
+    tp->page[slot].last_used = tp->clock;
+    return &tp->page[slot];
+}
+
+/* keep every chunk overlapping pixels [x0, x1) paged in */
+void tile_pages_window(const World *world, int x0, int x1) {
+    TilePages *tp = world->pages;
+    if (!tp) return;
+    tp->clock++;
+    int c0 = x0 > 0 ? x0 / CHUNK_W : 0;
+    int c1 = x1 > 0 ? (x1 - 1) / CHUNK_W : -1;
+    if (c1 >= tp->chunks) c1 = tp->chunks - 1;
+    for (int c=c0;c<=c1;c++) tile_page(world, c);
+}
+
+/* ---------------- SOLID queries (tile grid) ---------------- */
+int tile_of(int v) {
+    /* floor division, so rects left of / above the map map to negative cells */
+    return v >= 0 ? v / TILE : -((-v + TILE - 1) / TILE);
+}
+
+/* TILE_* of cell (col, row), which must be on the grid */
+int tile_at(const World *world, int col, int row) {
+    const TilePages *tp = world->pages;
+    if (!tp) return world->tile_kind[row*world->grid_cols + col];
+    int c = col / CHUNK_TILES, slot = tp->page_of[c];
+    if (slot < 0) return world->file_tiles[(size_t)row*world->grid_cols + col];
+    const TilePage *p = &tp->page[slot];
+    return p->kind[row*p->cols + col - c*CHUNK_TILES];
+}
+
+/* The part of cell (col, row) a tile of kind fills: the full tile, or the
+   lower half for a 't' cap. */
+SDL_Rect tile_cell(int kind, int col, int row) {
+    if (kind == TILE_CAP) return (SDL_Rect){col*TILE, row*TILE + TILE/2, TILE, TILE/2};
+    return (SDL_Rect){col*TILE, row*TILE, TILE, TILE};
+}
+
+/* First solid tile (in map row-major order) overlapping r: returns its
+   TILE_* kind, or -1, and stores that tile's rect in *contact. Resolving
+   against the tile rather than the (possibly merged) solid keeps answers
+   identical to a linear aabb_int scan over unmerged tiles, and lets paged
+   levels answer from their pages. */
+int solid_hit(const World *world, SDL_Rect r, SDL_Rect *contact) {
+    int c0 = tile_of(r.x), c1 = tile_of(r.x + (r.w > 0 ? r.w - 1 : 0));
+    int r0 = tile_of(r.y), r1 = tile_of(r.y + (r.h > 0 ? r.h - 1 : 0));
+    if (c0 < 0) c0 = 0;
+    if (r0 < 0) r0 = 0;
+    if (c1 >= world->grid_cols) c1 = world->grid_cols - 1;
+    if (r1 >= world->grid_rows) r1 = world->grid_rows - 1;
+    for (int j=r0;j<=r1;j++){
+        for (int i=c0;i<=c1;i++){
+            int kind = tile_at(world, i, j);
+            if (kind == TILE_EMPTY) continue;
+            SDL_Rect cell = tile_cell(kind, i, j);
+            if (aabb_int(r, cell)) {
+                if (contact) *contact = cell;
+                return kind;
+            }
+        }
+    }
+    return -1;
+}
+
+/* ---------------- COLLISION helpers for player (float rect) ---------------- */
+/* move the player by dx/dy pixels, stopping at the first solid hit */
+void resolve_horz_collision(const World *world, Player *p, float dx) {
+    SDL_FRect fr = p->r;
+    fr.x += dx;
+    /* build integer rect to test against solids */
+    SDL_Rect test = {(int)roundf(fr.x),(int)roundf(fr.y),(int)roundf(fr.w),(int)roundf(fr.h)};
+    SDL_Rect c;
+    if (solid_hit(world, test, &c) >= 0) {
+        if (dx > 0) {
+            p->r.x = c.x - p->r.w;
+        } else if (dx < 0) {
+            p->r.x = c.x + c.w;
+        }
+        p->vx = 0;
+        return;
+    }
+    p->r.x += dx;
+}
+void resolve_vert_collision(const World *world, Player *p, float dy) {
+    SDL_FRect fr = p->r;
+    fr.y += dy;
+    SDL_Rect test = {(int)roundf(fr.x),(int)roundf(fr.y),(int)roundf(fr.w),(int)roundf(fr.h)};
+    p->on_ground = 0;
+    SDL_Rect c;
+    if (solid_hit(world, test, &c) >= 0) {
+        if (dy > 0) {
+            p->r.y = c.y - p->r.h;
+            p->on_ground = 1;
+        } else if (dy < 0) {
+            p->r.y = c.y + c.h;
+        }
+        p->vy = 0;
+        return;
+    }
+    p->r.y += dy;
+}
+
+/* ---------------- JOB pool ----------------
+   A fixed pool of worker threads for data-parallel loops. parallel_for
+   splits [0, n) into grain-sized chunks that the workers and the
+   calling thread claim from a shared atomic counter until none are left,
+   so a thread that finishes early just takes more chunks. The job body
+   may only write state owned by its own index range. */
+#define MAX_WORKERS 15
+#define JOB_CHUNK 64   /* grain for per-entity jobs */
+typedef void (*JobFn)(int begin, int end, void *ctx);
+int job_threads = -1;   /* --threads N; -1 = one per CPU beyond the main thread */
+SDL_Thread *job_workers[MAX_WORKERS];
+int job_worker_count = 0;
+SDL_sem *job_start = NULL;
+SDL_sem *job_done = NULL;
+SDL_atomic_t job_next;
+SDL_atomic_t job_quit;
+SDL_atomic_t job_busy;   /* a parallel_for is in flight */
+JobFn job_fn;
+void *job_ctx;
+int job_n, job_grain;
+
+void job_run_chunks(void) {
+    for (;;) {
+        int begin = SDL_AtomicAdd(&job_next, job_grain);
+        if (begin >= job_n) break;
+        int end = begin + job_grain < job_n ? begin + job_grain : job_n;
+        job_fn(begin, end, job_ctx);
+    }
+}
+
+int job_worker_main(void *arg) {
+    (void)arg;
+    for (;;) {
+        SDL_SemWait(job_start);
+        if (SDL_AtomicGet(&job_quit)) break;
+        job_run_chunks();
+        SDL_SemPost(job_done);
+    }
+    return 0;
+}
+
+void jobs_init(void) {
+    int n = job_threads >= 0 ? job_threads : SDL_GetCPUCount() - 1;
+    if (n > MAX_WORKERS) n = MAX_WORKERS;
+    if (n <= 0) return;
+    job_start = SDL_CreateSemaphore(0);
+    job_done = SDL_CreateSemaphore(0);
+    if (!job_start || !job_done) return;
+    SDL_AtomicSet(&job_quit, 0);
+    while (job_worker_count < n) {
+        SDL_Thread *t = SDL_CreateThread(job_worker_main, "job", NULL);
+        if (!t) break;   /* run with however many started */
+        job_workers[job_worker_count++] = t;
+    }
+}
+
+void jobs_shutdown(void) {
+    SDL_AtomicSet(&job_quit, 1);
+    for (int i=0;i<job_worker_count;i++) SDL_SemPost(job_start);
+    for (int i=0;i<job_worker_count;i++) SDL_WaitThread(job_workers[i], NULL);
+    job_worker_count = 0;
+    if (job_start) SDL_DestroySemaphore(job_start);
+    if (job_done) SDL_DestroySemaphore(job_done);
+    job_start = job_done = NULL;
+}
+
+/* run fn over [0, n) on the pool; returns when every chunk is done */
+void parallel_for(int n, int grain, JobFn fn, void *ctx) {
+    int chunks = (n + grain - 1) / grain;
+    /* one job at a time: a nested or concurrent call just runs inline */
+    if (chunks <= 1 || job_worker_count == 0 || !SDL_AtomicCAS(&job_busy, 0, 1)) { fn(0, n, ctx); return; }
+    job_fn = fn; job_ctx = ctx; job_n = n; job_grain = grain;
+    SDL_AtomicSet(&job_next, 0);
+    int wake = chunks - 1 < job_worker_count ? chunks - 1 : job_worker_count;
+    for (int i=0;i<wake;i++) SDL_SemPost(job_start);
+    job_run_chunks();
+    for (int i=0;i<wake;i++) SDL_SemWait(job_done);
+    SDL_AtomicSet(&job_busy, 0);
+}
+
+/* ---------------- ENEMY movement ----------------
+   Each enemy reads only the static solids and writes only its own slots,
+   so big crowds are split across the job pool; small ones aren't worth
+   the hand-off. Only the enemies in the active span move; the store is
+   then put back in x order. */
+#define PARALLEL_MIN_ENEMIES 512
+
+typedef struct {
+    World *world;
+    int base;   /* store index of job index 0 */
+    float dt;
+} EnemyJob;
+
+void update_enemy_range(int begin, int end, void *ctx) {
+    const EnemyJob *job = ctx;
+    World *world = job->world;
+    float dt = job->dt;
+    EnemyStore *e = &world->enemies;
+    for (int i=job->base+begin;i<job->base+end;i++){
+        float oldx = e->fx[i];
+        e->prev_x[i] = oldx;
+        e->fx[i] += e->dir[i] * e->speed[i] * dt * TUNING_HZ;
+        e->x[i] = (int)roundf(e->fx[i]);
+        /* horizontal collision with solids */
+        if (solid_hit(world, enemy_rect(world, i), NULL) >= 0) {
+            /* undo and flip */
+            e->fx[i] = oldx;
+            e->x[i] = (int)roundf(oldx);
+            e->dir[i] *= -1;
+        }
+        /* basic ground ahead check; if no block below ahead, flip */
+        int ahead_x = e->x[i] + (e->dir[i]>0? e->w[i] + 2 : -4);
+        int foot_y = e->y[i] + e->h[i] + 2;
+        SDL_Rect foot = {ahead_x, foot_y, 2, 2};
+        if (solid_hit(world, foot, NULL) < 0) e->dir[i] *= -1;
+    }
+}
+
+void swap_enemies(EnemyStore *e, int a, int b) {
+    int ti; float tf;
+    ti = e->x[a]; e->x[a] = e->x[b]; e->x[b] = ti;
+    ti = e->y[a]; e->y[a] = e->y[b]; e->y[b] = ti;
+    ti = e->w[a]; e->w[a] = e->w[b]; e->w[b] = ti;
+    ti = e->h[a]; e->h[a] = e->h[b]; e->h[b] = ti;
+    ti = e->dir[a]; e->dir[a] = e->dir[b]; e->dir[b] = ti;
+    tf = e->speed[a]; e->speed[a] = e->speed[b]; e->speed[b] = tf;
+    tf = e->fx[a]; e->fx[a] = e->fx[b]; e->fx[b] = tf;
+    tf = e->prev_x[a]; e->prev_x[a] = e->prev_x[b]; e->prev_x[b] = tf;
+}
+
+/* insertion sort from lo; past hi nothing moved, so it stops at the
+   first entry already in order */
+void resort_enemies(World *world, int lo, int hi) {
+    EnemyStore *e = &world->enemies;
+    for (int i=lo>0?lo:1;i<e->count;i++){
+        if (e->x[i] >= e->x[i-1]) { if (i >= hi) break; continue; }
+        for (int j=i;j>0 && e->x[j] < e->x[j-1];j--) swap_enemies(e, j, j-1);
+        world->proxies_valid = 0;
+    }
+}
+
+/* move enemies [lo, hi) */
+void update_enemies(World *world, int lo, int hi, float dt) {
+    EnemyJob job = {world, lo, dt};
+    if (hi - lo >= PARALLEL_MIN_ENEMIES) parallel_for(hi - lo, JOB_CHUNK, update_enemy_range, &job);
+    else update_enemy_range(0, hi - lo, &job);
+    resort_enemies(world, lo, hi);
+}
+
+/* ---------------- BROADPHASE (sort and sweep) ----------------
+   Enemies and mushrooms kept as proxies sorted by left edge. Entities move
+   at most a few pixels per tick, so re-sorting last tick's order with
+   insertion sort is close to linear; the list is rebuilt (qsort) only
+   after an entity is removed or reordered in its store, the active spans
+   change, or a level is built. The sweep then tests just the proxies
+   whose x ranges overlap, instead of every pair. */
+int proxy_cmp(const void *pa, const void *pb) {
+    const Proxy *a = pa, *b = pb;
+    if (a->minx != b->minx) return a->minx < b->minx ? -1 : 1;
+    if (a->kind != b->kind) return a->kind - b->kind;
+    return a->idx - b->idx;
+}
+
+void proxy_refresh(const World *world, Proxy *p) {
+    SDL_Rect r = p->kind == PROXY_ENEMY ? enemy_rect(world, p->idx) : mush_rect(world, p->idx);
+    p->minx = r.x; p->maxx = r.x + r.w;
+    p->miny = r.y; p->maxy = r.y + r.h;
+}
+
+/* proxies for enemies [elo, ehi) and mushrooms [mlo, mhi) */
+void broadphase_update(World *world, int elo, int ehi, int mlo, int mhi) {
+    int *span = world->proxy_span;
+    if (span[0] != elo || span[1] != ehi || span[2] != mlo || span[3] != mhi) world->proxies_valid = 0;
+    if (!world->proxies_valid) {
+        span[0] = elo; span[1] = ehi; span[2] = mlo; span[3] = mhi;
+        world->proxy_count = 0;
+        for (int i=elo;i<ehi;i++) world->proxies[world->proxy_count++] = (Proxy){0, 0, 0, 0, PROXY_ENEMY, i};
+        for (int i=mlo;i<mhi;i++) world->proxies[world->proxy_count++] = (Proxy){0, 0, 0, 0, PROXY_MUSH, i};
+        for (int i=0;i<world->proxy_count;i++) proxy_refresh(world, &world->proxies[i]);
+        qsort(world->proxies, world->proxy_count, sizeof(Proxy), proxy_cmp);
+        world->proxies_valid = 1;
+        return;
+    }
+    for (int i=0;i<world->proxy_count;i++) proxy_refresh(world, &world->proxies[i]);
+    for (int i=1;i<world->proxy_count;i++){
+        Proxy p = world->proxies[i];
+        int j = i - 1;
+        while (j >= 0 && proxy_cmp(&world->proxies[j], &p) > 0) { world->proxies[j+1] = world->proxies[j]; j--; }
+        world->proxies[j+1] = p;
+    }
+}
+
+/* call on_pair for every overlapping pair, a before b in x order */
+void broadphase_sweep(World *world, void (*on_pair)(World *world, const Proxy *a, const Proxy *b)) {
+    for (int i=0;i<world->proxy_count;i++){
+        const Proxy *a = &world->proxies[i];
+        for (int j=i+1;j<world->proxy_count && world->proxies[j].minx < a->maxx;j++){
+            const Proxy *b = &world->proxies[j];
+            if (a->miny < b->maxy && b->miny < a->maxy) on_pair(world, a, b);
+        }
+    }
+}
+
+/* Enemies that touch turn away from each other; mushrooms block enemies.
+   Directions are set, not flipped, so a pair that stays overlapping for
+   a few ticks doesn't jitter. */
+void entity_pair(World *world, const Proxy *a, const Proxy *b) {
+    if (a->kind == PROXY_MUSH && b->kind == PROXY_MUSH) return;
+    /* a is left of (or level with) b */
+    if (a->kind == PROXY_ENEMY) world->enemies.dir[a->idx] = -1;
+    if (b->kind == PROXY_ENEMY) world->enemies.dir[b->idx] = 1;
+}
+
+/* ---------------- ACTIVE region ----------------
+   Only entities within sim_margin tiles either side of the view are
+   simulated; the rest stay frozen where they were until the camera comes
+   near again. Together with the x-sorted stores this keeps the work per
+   tick proportional to the view, not to the level length. */
+
+/* left edge of the view that follows focus_x */
+int camera_x(const World *world, float focus_x) {
+    int camx = (int)focus_x - SCREEN_W/2;
+    if (camx > world->width - SCREEN_W) camx = world->width - SCREEN_W;
+    if (camx < 0) camx = 0;
+    return camx;
+}
+
+/* pixel range [*x0, *x1) simulated this tick for the view at camx */
+void active_region(int camx, int *x0, int *x1) {
+    if (sim_margin < 0) { *x0 = -(1 << 30); *x1 = 1 << 30; return; }
+    *x0 = camx - sim_margin * TILE;
+    *x1 = camx + SCREEN_W + sim_margin * TILE;
+}
+
+/* ---------------- VISIBILITY culling ----------------
+   Everything is culled against the camera window [camx, camx + SCREEN_W)
+   before it is submitted. cull_stats counts what each pass considered and
+   what it actually drew this frame (F3 shows it on screen). */
+typedef struct {
+    int solids_drawn, solids_total;
+    int chunks_drawn, chunks_total;
+    int coins_drawn, coins_total;
+    int mush_drawn, mush_total;
+    int enemies_drawn, enemies_total;
+} CullStats;
+CullStats cull_stats;
+int show_stats = 0;
+
+int on_screen(SDL_Rect r, int camx) {
+    return r.x + r.w > camx && r.x < camx + SCREEN_W;
+}
+
+/* ---------------- RENDER helpers ---------------- */
+void draw_solid(SDL_Renderer *ren, SDL_Rect r, int offx) {
+    r.x -= offx;
+    draw_rect(ren, r.x, r.y, r.w, r.h, BLOCK);
+    /* full blocks get a highlight strip per tile row, merged or not */
+    if (r.h % TILE == 0) {
+        for (int y=r.y;y<r.y+r.h;y+=TILE) draw_rect(ren, r.x, y, r.w, 6, (SDL_Color){230,150,90,255});
+    }
+}
+
+/* Static level layer: solids never change after build_level, so each
+   CHUNK_W-wide column is drawn once into a render-target texture and
+   draw_level blits only the chunks overlapping the camera. Textures are
+   baked on first use and kept in a CHUNK_CACHE-slot LRU cache, so
+   texture memory is bounded by the view, not the level length; the
+   chunk just past each screen edge is baked ahead (one per frame) so
+   scrolling doesn't stall. Falls back to drawing solids directly if
+   render targets are unavailable. */
+#define CHUNK_CACHE 8   /* the view spans at most SCREEN_W / CHUNK_W + 2 chunks */
+
+typedef struct {
+    SDL_Texture *tx;
+    int chunk;          /* chunk baked into tx, or -1 */
+    Uint32 last_used;   /* chunk_clock when last drawn */
+} ChunkSlot;
+
+ChunkSlot chunk_slots[CHUNK_CACHE];
+Uint32 chunk_clock = 0;
+int chunk_bakes = 0;           /* chunks baked since the level started */
+int level_chunks_serial = -1;  /* level_serial the cache holds chunks of */
+const World *level_chunks_world = NULL;   /* ... and the World it belongs to */
+int level_chunks_ok = 1;       /* cleared when render targets fail */
+
+void free_level_chunks(void) {
+    for (int i=0;i<CHUNK_CACHE;i++){
+        if (chunk_slots[i].tx) SDL_DestroyTexture(chunk_slots[i].tx);
+        chunk_slots[i].tx = NULL;
+        chunk_slots[i].chunk = -1;
+    }
+    chunk_bakes = 0;
+}
+
+/* forget every baked chunk, keeping the textures (targets were reset) */
+void invalidate_level_chunks(void) {
+    for (int i=0;i<CHUNK_CACHE;i++) chunk_slots[i].chunk = -1;
+}
+
+ChunkSlot *find_chunk(int c) {
+    for (int i=0;i<CHUNK_CACHE;i++) if (chunk_slots[i].chunk == c) return &chunk_slots[i];
+    return NULL;
+}
+
+/* bake chunk c into the least recently used slot */
+ChunkSlot *bake_chunk(SDL_Renderer *ren, const World *world, int c) {
+    ChunkSlot *slot = &chunk_slots[0];
+    for (int i=1;i<CHUNK_CACHE && slot->chunk >= 0;i++){
+        if (chunk_slots[i].chunk < 0 || chunk_slots[i].last_used < slot->last_used) slot = &chunk_slots[i];
+    }
+    render_flush(ren);
+    if (!slot->tx) slot->tx = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, CHUNK_W, world->grid_rows * TILE);
+    if (!slot->tx || SDL_SetRenderTarget(ren, slot->tx) != 0) {
+        SDL_SetRenderTarget(ren, NULL);
+        free_level_chunks();
+        level_chunks_ok = 0;
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(slot->tx, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
+    SDL_RenderClear(ren);
+    int x0 = c * CHUNK_W;
+    if (world->pages) {
+        /* a paged level's chunk carries its own solids */
+        const TilePage *p = tile_page(world, c);
+        for (int i=0;i<p->solids_count;i++) draw_solid(ren, p->solids[i], x0);
+    } else {
+        /* the solids touching the chunk, from the grid cells it covers */
+        int col0 = c * CHUNK_TILES, col1 = col0 + CHUNK_TILES;
+        if (col1 > world->grid_cols) col1 = world->grid_cols;
+        for (int j=0;j<world->grid_rows;j++){
+            for (int i=col0;i<col1;i++){
+                int s = world->solid_grid[j*world->grid_cols + i];
+                if (s < 0) continue;
+                SDL_Rect r = world->solids[s];
+                /* a merged solid may cover several cells; draw it from its first one inside the chunk */
+                int first_col = r.x < x0 ? col0 : r.x / TILE;
+                int first_row = r.y / TILE;
+                if (i == first_col && j == first_row) draw_solid(ren, r, x0);
+            }
+        }
+    }
+    render_flush(ren);
+    SDL_SetRenderTarget(ren, NULL);
+    slot->chunk = c;
+    chunk_bakes++;
+    return slot;
+}
+
+void draw_level(SDL_Renderer *ren, const World *world, int camx) {
+    if (level_chunks_serial != world->level_serial || level_chunks_world != world) {
+        /* new level (its height may differ): drop the cached textures */
+        free_level_chunks();
+        level_chunks_serial = world->level_serial;
+        level_chunks_world = world;
+        level_chunks_ok = SDL_RenderTargetSupported(ren) && world->grid_rows > 0;
+    }
+    int count = (world->width + CHUNK_W - 1) / CHUNK_W;
+    if (level_chunks_ok) {
+        render_flush(ren);   /* background goes under the chunks */
+        chunk_clock++;
+        int first = camx > 0 ? camx / CHUNK_W : 0;
+        int last = (camx + SCREEN_W - 1) / CHUNK_W;
+        if (last >= count) last = count - 1;
+        for (int c=first;c<=last && level_chunks_ok;c++){
+            ChunkSlot *slot = find_chunk(c);
+            if (!slot) slot = bake_chunk(ren, world, c);
+            if (!slot) break;
+            slot->last_used = chunk_clock;
+            SDL_Rect dst = {c * CHUNK_W - camx, 0, CHUNK_W, world->grid_rows * TILE};
+            SDL_RenderCopy(ren, slot->tx, NULL, &dst);
+            render_batches++;
+            cull_stats.chunks_drawn++;
+        }
+        /* bake ahead: the next chunk on either side, at most one a frame */
+        if (level_chunks_ok) {
+            if (last + 1 < count && !find_chunk(last + 1)) bake_chunk(ren, world, last + 1);
+            else if (first > 0 && !find_chunk(first - 1)) bake_chunk(ren, world, first - 1);
+        }
+        if (level_chunks_ok) {
+            cull_stats.chunks_total = count;
+            return;
+        }
+    }
+    /* solids */
+    if (world->pages) {
+        /* only the on-screen chunks' solids, paged in as needed */
+        int first = camx > 0 ? camx / CHUNK_W : 0;
+        int last = (camx + SCREEN_W - 1) / CHUNK_W;
+        if (last >= count) last = count - 1;
+        for (int c=first;c<=last;c++){
+            const TilePage *p = tile_page(world, c);
+            cull_stats.solids_total += p->solids_count;
+            for (int i=0;i<p->solids_count;i++){
+                if (!on_screen(p->solids[i], camx)) continue;
+                draw_solid(ren, p->solids[i], camx);
+                cull_stats.solids_drawn++;
+            }
+        }
+        return;
+    }
+    cull_stats.solids_total = world->solids_count;
+    for (int i=0;i<world->solids_count;i++){
+        if (!on_screen(world->solids[i], camx)) continue;
+        draw_solid(ren, world->solids[i], camx);
+        cull_stats.solids_drawn++;
+    }
+    /* grass caps (visual) - scan level rows */
+    /* not drawing separate t-caps here since solids include t */
+}
+
+void draw_player(SDL_Renderer *ren, Player *p, int camx) {
+    SDL_FRect pr = p->r;
+    SDL_Rect rr = {(int)roundf(pr.x)-camx, (int)roundf(pr.y), (int)roundf(pr.w), (int)roundf(pr.h)};
+    SDL_Color col = p->big ? PLAYER_BIG_COL : PLAYER_COL;
+    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, col);
+    /* small hat */
+    draw_rect(ren, rr.x+4, rr.y-6, rr.w-8, 6, (SDL_Color){30,30,30,255});
+}
+
+void draw_enemy(SDL_Renderer *ren, SDL_Rect rr, int camx) {
+    rr.x -= camx;
+    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, ENEMY_COL);
+    draw_rect(ren, rr.x + rr.w/2 - 2, rr.y + 8, 4, 4, (SDL_Color){250,240,220,255});
+}
+
+void draw_coin(SDL_Renderer *ren, SDL_Rect rr, int camx) {
+    rr.x -= camx;
+    draw_rect(ren, rr.x, rr.y, rr.w, rr.h, COIN_COL);
+}
+
+void draw_mush(SDL_Renderer *ren, SDL_Rect rr, int camx) {
+    rr.x -= camx;
+    /* cap */
+    draw_rect(ren, rr.x, rr.y, rr.w, rr.h/2, MUSH_COL);
+    /* stem */
+    draw_rect(ren, rr.x + rr.w/4, rr.y + rr.h/4, rr.w/2, rr.h/2, (SDL_Color){250,230,200,255});
+}
+
+void draw_flag(SDL_Renderer *ren, SDL_Rect flag, int camx) {
+    SDL_Rect fr = flag;
+    fr.x -= camx;
+    /* pole */
+    draw_rect(ren, fr.x + fr.w/2 - 2, fr.y + fr.h - 4*TILE, 4, 4*TILE, (SDL_Color){220,220,220,255});
+    /* flag */
+    SDL_Point pts[3] = {{fr.x + fr.w/2 + 4, fr.y + fr.h - 4*TILE + 30}, {fr.x + fr.w/2 + 38, fr.y + fr.h - 4*TILE + 18}, {fr.x + fr.w/2 + 38, fr.y + fr.h - 4*TILE + 42}};
+    /* draw as filled triangle using rects (simple) */
+    draw_rect(ren, pts[0].x, pts[0].y, 34, 24, FLAG_COL);
+}
+
+/* ---------------- TEXT (glyph atlas + static string cache) ----------------
+   The font is rasterized once into a single atlas texture holding every
+   printable ASCII glyph in white; dynamic strings (the HUD) are drawn as one
+   SDL_RenderCopy per character, tinted with SDL_SetTextureColorMod.
+   Fixed strings (title, messages) are rendered once with TTF and kept as
+   textures until shutdown, so no surfaces or textures are created per frame.
+   The atlas pixels and metrics are also saved to a cache file; when that
+   file matches the font, it is loaded instead and the font is never
+   opened (fixed strings are then drawn from the atlas too). */
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+typedef struct {
+    SDL_Texture *tex;
+    SDL_Rect src[GLYPH_COUNT];  /* glyph cell in the atlas */
+    int advance[GLYPH_COUNT];   /* pen advance in pixels */
+    int height;
+} GlyphAtlas;
+GlyphAtlas atlas;
+
+#define MAX_CACHED_TEXT 16
+typedef struct {
+    const char *str;
+    SDL_Color col;
+    SDL_Texture *tex;
+    int w, h;
+} CachedText;
+CachedText text_cache[MAX_CACHED_TEXT];
+int text_cache_count = 0;
+
+/* rasterize the glyphs into a white RGBA32 sheet and fill a's metrics;
+   touches no renderer, so it can run on the loader thread */
+SDL_Surface *atlas_rasterize(TTF_Font *font, GlyphAtlas *a) {
+    SDL_Color white = {255,255,255,255};
+    SDL_Surface *glyphs[GLYPH_COUNT] = {0};
+    int total_w = 0;
+    a->height = TTF_FontHeight(font);
+    for (int i=0;i<GLYPH_COUNT;i++){
+        Uint16 ch = (Uint16)(GLYPH_FIRST + i);
+        int minx, maxx, miny, maxy, adv;
+        if (TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &adv) != 0) adv = 0;
+        a->advance[i] = adv;
+        glyphs[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        if (glyphs[i]) {
+            if (glyphs[i]->h > a->height) a->height = glyphs[i]->h;
+            total_w += glyphs[i]->w + 1;
+        }
+    }
+    SDL_Surface *sheet = total_w > 0 ? SDL_CreateRGBSurfaceWithFormat(0, total_w, a->height, 32, SDL_PIXELFORMAT_RGBA32) : NULL;
+    int x = 0;
+    for (int i=0;i<GLYPH_COUNT;i++){
+        if (!glyphs[i]) { a->src[i] = (SDL_Rect){0,0,0,0}; continue; }
+        if (sheet) {
+            SDL_Rect dst = {x, 0, glyphs[i]->w, glyphs[i]->h};
+            /* copy alpha as-is instead of blending onto the empty sheet */
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphs[i], NULL, sheet, &dst);
+            a->src[i] = dst;
+            x += glyphs[i]->w + 1;
+        }
+        SDL_FreeSurface(glyphs[i]);
+    }
+    return sheet;
+}
+
+/* make a (filled by atlas_rasterize or font_cache_load) the live atlas;
+   frees sheet */
+int atlas_upload(SDL_Renderer *ren, const GlyphAtlas *a, SDL_Surface *sheet) {
+    atlas = *a;
+    atlas.tex = SDL_CreateTextureFromSurface(ren, sheet);
+    SDL_FreeSurface(sheet);
+    if (!atlas.tex) return 0;
+    SDL_SetTextureBlendMode(atlas.tex, SDL_BLENDMODE_BLEND);
+    return 1;
+}
+
+/* Font cache file: a header, then the sheet's alpha channel, one byte per
+   pixel, row-major (the colour is always white). All fields little-endian.
+   It is tied to the font by path, point size and file size. */
+#define FONT_CACHE_VERSION 1
+typedef struct {
+    char magic[4];          /* "RPFA" */
+    Uint32 version;
+    char font_path[256];
+    Uint32 point_size;
+    Uint32 font_bytes;      /* size of the .ttf it was built from */
+    Uint32 height;
+    Uint32 sheet_w, sheet_h;
+    Uint32 src[GLYPH_COUNT][4];
+    Uint32 advance[GLYPH_COUNT];
+} FontCacheHeader;
+
+/* bytes in the file at path, or -1 */
+long file_bytes(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    long n = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    fclose(f);
+    return n;
+}
+
+void font_cache_header(FontCacheHeader *h, const char *font_path, int point_size) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, "RPFA", 4);
+    h->version = SDL_SwapLE32(FONT_CACHE_VERSION);
+    snprintf(h->font_path, sizeof(h->font_path), "%s", font_path);
+    h->point_size = SDL_SwapLE32((Uint32)point_size);
+    h->font_bytes = SDL_SwapLE32((Uint32)file_bytes(font_path));
+}
+
+/* sheet and metrics from cache_path if it was built from this font */
+SDL_Surface *font_cache_load(const char *cache_path, const char *font_path, int point_size, GlyphAtlas *a) {
+    FontCacheHeader want, h;
+    font_cache_header(&want, font_path, point_size);
+    FileView v;
+    if (!file_view_open(&v, cache_path)) return NULL;
+    SDL_Surface *sheet = NULL;
+    if (v.size < sizeof(h)) goto done;
+    memcpy(&h, v.data, sizeof(h));
+    if (memcmp(h.magic, want.magic, 4) != 0 || h.version != want.version || memcmp(h.font_path, want.font_path, sizeof(h.font_path)) != 0
+        || h.point_size != want.point_size || h.font_bytes != want.font_bytes) goto done;
+    Uint32 w = SDL_SwapLE32(h.sheet_w), ht = SDL_SwapLE32(h.sheet_h);
+    if (w == 0 || w > 65535 || ht == 0 || ht > 4096 || (size_t)w * ht > v.size - sizeof(h)) goto done;
+    sheet = SDL_CreateRGBSurfaceWithFormat(0, (int)w, (int)ht, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!sheet) goto done;
+    const unsigned char *alpha = v.data + sizeof(h);
+    for (Uint32 y=0;y<ht;y++){
+        Uint8 *row = (Uint8 *)sheet->pixels + y * sheet->pitch;
+        for (Uint32 x=0;x<w;x++){
+            row[4*x] = row[4*x+1] = row[4*x+2] = 255;   /* RGBA32 is R,G,B,A in memory */
+            row[4*x+3] = alpha[y * w + x];
+        }
+    }
+    a->height = (int)SDL_SwapLE32(h.height);
+    for (int i=0;i<GLYPH_COUNT;i++){
+        a->src[i] = (SDL_Rect){(int)SDL_SwapLE32(h.src[i][0]), (int)SDL_SwapLE32(h.src[i][1]), (int)SDL_SwapLE32(h.src[i][2]), (int)SDL_SwapLE32(h.src[i][3])};
+        a->advance[i] = (int)SDL_SwapLE32(h.advance[i]);
+    }
+done:
+    file_view_close(&v);
+    return sheet;
+}
+
+/* write through a temporary file so a crash never leaves half a cache */
+int font_cache_save(const char *cache_path, const char *font_path, int point_size, const GlyphAtlas *a, const SDL_Surface *sheet) {
+    FontCacheHeader h;
+    font_cache_header(&h, font_path, point_size);
+    h.height = SDL_SwapLE32((Uint32)a->height);
+    h.sheet_w = SDL_SwapLE32((Uint32)sheet->w);
+    h.sheet_h = SDL_SwapLE32((Uint32)sheet->h);
+    for (int i=0;i<GLYPH_COUNT;i++){
+        h.src[i][0] = SDL_SwapLE32((Uint32)a->src[i].x); h.src[i][1] = SDL_SwapLE32((Uint32)a->src[i].y);
+        h.src[i][2] = SDL_SwapLE32((Uint32)a->src[i].w); h.src[i][3] = SDL_SwapLE32((Uint32)a->src[i].h);
+        h.advance[i] = SDL_SwapLE32((Uint32)a->advance[i]);
+    }
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cache_path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    unsigned char *row = malloc(sheet->w);
+    ok = ok && row;
+    for (int y=0;ok && y<sheet->h;y++){
+        const Uint8 *px = (const Uint8 *)sheet->pixels + y * sheet->pitch;
+        for (int x=0;x<sheet->w;x++) row[x] = px[4*x+3];
+        ok = fwrite(row, 1, sheet->w, f) == (size_t)sheet->w;
+    }
+    free(row);
+    if (fclose(f) != 0) ok = 0;
+    remove(cache_path);   /* rename does not replace on Windows */
+    if (!ok || rename(tmp, cache_path) != 0) { remove(tmp); return 0; }
+    return 1;
+}
+
+int text_width(const char *str) {
+    int w = 0;
+    for (const char *c = str; *c; c++){
+        if (*c >= GLYPH_FIRST && *c <= GLYPH_LAST) w += atlas.advance[*c - GLYPH_FIRST];
+    }
+    return w;
+}
+
+/* draw a dynamic string from the atlas; no-op until the atlas exists */
+void draw_text(SDL_Renderer *ren, int x, int y, const char *str, SDL_Color col) {
+    if (!atlas.tex) return;
+    render_flush(ren);
+    SDL_SetTextureColorMod(atlas.tex, col.r, col.g, col.b);
+    SDL_SetTextureAlphaMod(atlas.tex, col.a);
+    for (const char *c = str; *c; c++){
+        if (*c < GLYPH_FIRST || *c > GLYPH_LAST) continue;
+        int gi = *c - GLYPH_FIRST;
+        if (atlas.src[gi].w > 0) {
+            SDL_Rect dst = {x, y, atlas.src[gi].w, atlas.src[gi].h};
+            SDL_RenderCopy(ren, atlas.tex, &atlas.src[gi], &dst);
+            render_batches++;
+        }
+        x += atlas.advance[gi];
+    }
+}
+
+/* persistent texture for a fixed string, rendered on first use */
+CachedText *cached_text(SDL_Renderer *ren, TTF_Font *font, const char *str, SDL_Color col) {
+    for (int i=0;i<text_cache_count;i++){
+        CachedText *t = &text_cache[i];
+        if (strcmp(t->str, str) == 0 && t->col.r == col.r && t->col.g == col.g && t->col.b == col.b && t->col.a == col.a) return t;
+    }
+    if (!font || text_cache_count >= MAX_CACHED_TEXT) return NULL;
+    SDL_Surface *s = TTF_RenderText_Blended(font, str, col);
+    if (!s) return NULL;
+    CachedText *t = &text_cache[text_cache_count];
+    t->tex = SDL_CreateTextureFromSurface(ren, s);
+    t->w = s->w; t->h = s->h;
+    SDL_FreeSurface(s);
+    if (!t->tex) return NULL;
+    t->str = str; t->col = col;
+    text_cache_count++;
+    return t;
+}
+
+/* draw a cached fixed string; x < 0 centers it horizontally. Without a
+   font (the atlas came from the cache) it is drawn from the atlas. */
+void draw_cached_text(SDL_Renderer *ren, TTF_Font *font, const char *str, SDL_Color col, int x, int y) {
+    CachedText *t = cached_text(ren, font, str, col);
+    if (!t) {
+        draw_text(ren, x < 0 ? (SCREEN_W - text_width(str))/2 : x, y, str, col);
+        return;
+    }
+    render_flush(ren);
+    SDL_Rect dst = { x < 0 ? (SCREEN_W - t->w)/2 : x, y, t->w, t->h };
+    SDL_RenderCopy(ren, t->tex, NULL, &dst);
+    render_batches++;
+}
+
+void text_shutdown(void) {
+    for (int i=0;i<text_cache_count;i++) SDL_DestroyTexture(text_cache[i].tex);
+    text_cache_count = 0;
+    if (atlas.tex) SDL_DestroyTexture(atlas.tex);
+    atlas.tex = NULL;
+}
+
+/* F4 overlay: one line per profiler phase, bottom-left */
+void draw_prof_overlay(SDL_Renderer *ren) {
+    if (!atlas.tex) return;
+    int line_h = atlas.height + 2;
+    int y = SCREEN_H - 8 - line_h * (PROF_COUNT + 1);
+    draw_rect(ren, 6, y - 4, 380, line_h * (PROF_COUNT + 1) + 8, (SDL_Color){255,255,255,200});
+    char buf[128];
+    snprintf(buf, sizeof(buf), "PHASE      MIN     AVG     MAX  ms (%d frames)", prof_frames < PROF_WINDOW ? prof_frames : PROF_WINDOW);
+    draw_text(ren, 12, y, buf, HUD_COL);
+    for (int p=0;p<PROF_COUNT;p++){
+        float mn, avg, mx;
+        prof_summary(p, PROF_WINDOW, &mn, &avg, &mx);
+        snprintf(buf, sizeof(buf), "%-8s %6.2f  %6.2f  %6.2f", PROF_NAMES[p], mn, avg, mx);
+        y += line_h;
+        draw_text(ren, 12, y, buf, HUD_COL);
+    }
+}
+
+/* ---------------- GAME INIT / START ---------------- */
+enum {STATE_TITLE, STATE_PLAY, STATE_LEVEL_CLEAR, STATE_GAME_OVER, STATE_WIN};
+
+struct Snapshot;
+struct LevelPrefetch;
+
+typedef struct {
+    int state;
+    int level_idx;
+    Player player;
+    int level_time;     /* seconds allowed for the level */
+    float level_clock;  /* simulated seconds since the level (re)started */
+    World world;
+    struct Snapshot *start_snap;   /* taken by start_level, restored by level_restart */
+    struct Telemetry *tel;         /* gameplay event sink, or NULL (see TELEMETRY) */
+    struct LevelPrefetch *prefetch;   /* levels built in the background, or NULL (see LEVEL PREFETCH) */
+} Game;
+
+/* ---------------- SNAPSHOTS ----------------
+   Everything a tick can change is the Game struct (which holds the World's
+   counts and pointers) and the mutable prefix of the level arena (entity
+   stores and broadphase proxies), so a snapshot is one struct copy plus one
+   memcpy, and restoring is the same in reverse. Static level data (solids,
+   grids) isn't copied; a snapshot only restores into the same Game and
+   level build it was taken from. The buffer is allocated on the first take
+   for a level and reused after, so rollback resimulation takes and restores
+   without allocating. */
+typedef struct Snapshot {
+    Game game;
+    size_t size, cap;
+    unsigned char *data;
+} Snapshot;
+
+int snapshot_take(const Game *g, Snapshot *s) {
+    const World *world = &g->world;
+    if (s->cap < world->state_bytes) {
+        unsigned char *p = realloc(s->data, world->state_bytes);
+        if (!p) return 0;
+        s->data = p;
+        s->cap = world->state_bytes;
+    }
+    s->game = *g;
+    s->size = world->state_bytes;
+    memcpy(s->data, world->arena.base, s->size);
+    return 1;
+}
+
+/* 0 if s wasn't taken on this Game's current level build */
+int snapshot_restore(Game *g, const Snapshot *s) {
+    const World *sw = &s->game.world, *world = &g->world;
+    if (!s->data || sw->arena.base != world->arena.base || sw->level_serial != world->level_serial
+        || s->size != world->state_bytes) return 0;
+    *g = s->game;
+    memcpy(g->world.arena.base, s->data, s->size);
+    return 1;
+}
+
+void snapshot_free(Snapshot *s) {
+    free(s->data);
+    memset(s, 0, sizeof(*s));
+}
+
+/* release a World's level storage and, for a paged level, its file */
+void world_free(World *world) {
+    if (world->file.data) file_view_close(&world->file);
+    world->file_tiles = NULL;
+    world->pages = NULL;
+    arena_free(&world->arena);
+}
+
+/* release everything a Game owns */
+void game_free(Game *g) {
+    if (g->start_snap) snapshot_free(g->start_snap);
+    free(g->start_snap);
+    g->start_snap = NULL;
+    world_free(&g->world);
+}
+
+/* the player's spawn point for the built level: baked, or found once by
+   dropping from the left safe position until hitting ground */
+SDL_FPoint player_start(World *world) {
+    if (world->player_start_known) return world->player_start;
+    int spawnx = 60;
+    int spawny = 0;
+    SDL_FRect temp = {.x = (float)spawnx, .y = (float)spawny, .w = TILE-12, .h = TILE-8};
+    float vy = 0;
+    for (int iter=0; iter<2000; iter++){
+        vy += 1.0f;
+        temp.y += vy;
+        SDL_Rect test = {(int)roundf(temp.x),(int)roundf(temp.y),(int)roundf(temp.w),(int)roundf(temp.h)};
+        SDL_Rect c;
+        if (solid_hit(world, test, &c) >= 0) {
+            /* snap above */
+            temp.y = c.y - temp.h;
+            break;
+        }
+    }
+    world->player_start = (SDL_FPoint){temp.x, temp.y};
+    world->player_start_known = 1;
+    return world->player_start;
+}
+
+/* ---------------- LEVEL PREFETCH ----------------
+   Levels from --levels are built off the main thread into a spare World
+   (file reads, validation, solids and sorting), and start_level swaps it
+   with the Game's World, so the old level's arena becomes the spare for
+   the next build. The asset loader builds level 0 and publishes it with
+   its done flag; after that the main thread starts a build of the level
+   after the current one while it is played. The builder owns the spare
+   until joined: thread is only touched by the main thread, and start_level
+   joins a build still running, since waiting for it beats starting over.
+   Built-in levels start from their baked tables and don't need this. */
+typedef struct LevelPrefetch {
+    World world;            /* the spare */
+    int want;               /* level last asked for */
+    int idx;                /* level world holds built, or -1 */
+    SDL_Thread *thread;     /* building world, or NULL */
+} LevelPrefetch;
+
+/* build pf->want into the spare; off the main thread, or before publishing */
+void level_prefetch_build(LevelPrefetch *pf) {
+    pf->idx = load_level(&pf->world, pf->want) ? pf->want : -1;
+}
+
+int level_prefetch_main(void *arg) {
+    level_prefetch_build(arg);
+    return 0;
+}
+
+void level_prefetch_join(LevelPrefetch *pf) {
+    if (pf->thread) SDL_WaitThread(pf->thread, NULL);
+    pf->thread = NULL;
+}
+
+/* main thread, once a frame: start building the level after g's one */
+void level_prefetch_next(Game *g) {
+    LevelPrefetch *pf = g->prefetch;
+    int want = g->level_idx + 1;
+    if (!pf || pf->thread || g->state != STATE_PLAY || want >= num_levels || pf->want == want) return;
+    pf->want = want;
+    pf->idx = -1;
+    pf->thread = SDL_CreateThread(level_prefetch_main, "level", pf);
+    /* no thread: start_level loads it when it is needed */
+}
+
+void start_level(Game *g, int idx) {
+    Player *pl = &g->player;
+    World *world = &g->world;
+    LevelPrefetch *pf = g->prefetch;
+    if (pf) level_prefetch_join(pf);
+    if (pf && pf->idx == idx) {
+        World built = pf->world;
+        pf->world = *world;
+        *world = built;
+        pf->idx = -1;
+    } else if (!load_level(world, idx)) {
+        /* load_level said which file; playing some other map instead would
+           hide it */
+        fprintf(stderr, "cannot start level %d from %s\n", idx + 1, level_dir);
+        exit(1);
+    }
+    SDL_FPoint at = player_start(world);
+    pl->r.x = at.x; pl->r.y = at.y; pl->r.w = TILE-12; pl->r.h = TILE-8;
+    pl->vx = pl->vy = 0;
+    pl->spawn.x = pl->r.x; pl->spawn.y = pl->r.y;
+    pl->prev.x = pl->r.x; pl->prev.y = pl->r.y;
+    g->level_idx = idx;
+    g->level_time = 300;
+    g->level_clock = 0;
+    if (!g->start_snap) g->start_snap = calloc(1, sizeof(Snapshot));
+    if (g->start_snap) snapshot_take(g, g->start_snap);
+}
+
+/* R: put the level back as it started without rebuilding it. Score, coins
+   and lives carry over, and the current screen is kept, as with a rebuild. */
+void level_restart(Game *g) {
+    Game keep = *g;
+    if (!g->start_snap || !snapshot_restore(g, g->start_snap)) {
+        start_level(g, g->level_idx < num_levels ? g->level_idx : num_levels - 1);
+        return;
+    }
+    g->state = keep.state;
+    g->player.score = keep.player.score;
+    g->player.coins = keep.player.coins;
+    g->player.lives = keep.player.lives;
+}
+
+void lose_life(Game *g) {
+    Player *p = &g->player;
+    p->lives--;
+    p->r.x = p->spawn.x;
+    p->r.y = p->spawn.y;
+    p->vx = p->vy = 0;
+    /* teleport: don't interpolate from the old position */
+    p->prev.x = p->r.x; p->prev.y = p->r.y;
+    if (p->lives <= 0) g->state = STATE_GAME_OVER;
+}
+
+/* new game from level 0 (title screen / game over) */
+void game_restart(Game *g) {
+    Player *pl = &g->player;
+    g->state = STATE_PLAY;
+    pl->score = 0; pl->coins = 0; pl->lives = 3;
+    start_level(g, 0);
+}
+
+/* Enter on a menu screen */
+void game_enter(Game *g) {
+    if (g->state == STATE_TITLE || g->state == STATE_GAME_OVER) {
+        game_restart(g);
+    } else if (g->state == STATE_LEVEL_CLEAR) {
+        if (g->level_idx + 1 >= num_levels) {
+            g->level_idx++;
+            g->state = STATE_WIN;
+        } else {
+            start_level(g, g->level_idx + 1);
+            g->state = STATE_PLAY;
+        }
+    }
+}
+
+/* ---------------- LEVEL BAKING ----------------
+   --bake-levels FILE: build every built-in map the normal way and write the
+   result as the C tables of baked_levels.h (see BAKED LEVELS). Rebuild with
+   the new file next to this one after changing LEVELS or level building,
+   then run --check-baked. */
+/* n ints, 16 per line; *col counts across calls */
+void bake_ints(FILE *f, const int *v, int n, int *col) {
+    for (int i=0;i<n;i++) fprintf(f, "%d,%s", v[i], ++*col % 16 == 0 ? "\n    " : " ");
+}
+
+int bake_levels(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) { fprintf(stderr, "cannot write %s\n", path); return 0; }
+    merge_solids = 1;
+    World world = {0};
+    fprintf(f, "/* baked_levels.h: generated by --bake-levels from LEVELS; do not edit. */\n");
+    fprintf(f, "#define BAKED_LEVELS_HASH 0x%016llxULL\n", (unsigned long long)levels_hash());
+    fprintf(f, "#define BAKED_LEVEL_COUNT %d\n\n", NUM_LEVELS);
+    for (int l=0;l<NUM_LEVELS;l++){
+        build_level(&world, LEVELS[l], 8);
+        player_start(&world);
+        CoinStore *c = &world.coins;
+        EnemyStore *e = &world.enemies;
+        MushStore *m = &world.mush;
+        const int *ints[] = {c->x, c->y, c->w, c->h, e->x, e->y, e->w, e->h, e->dir, m->x, m->y, m->w, m->h};
+        int counts[] = {c->count, c->count, c->count, c->count, e->count, e->count, e->count, e->count, e->count, m->count, m->count, m->count, m->count};
+        int cells = world.grid_cols * world.grid_rows;
+        /* every array gets a trailing 0 so none is empty */
+        int col = 0;
+        fprintf(f, "const int baked%d_ints[] = {\n    ", l);
+        for (int k=0;k<13;k++) bake_ints(f, ints[k], counts[k], &col);
+        bake_ints(f, (const int *)world.solids, 4 * world.solids_count, &col);
+        bake_ints(f, world.solid_grid, cells, &col);
+        fprintf(f, "0\n};\nconst float baked%d_floats[] = {", l);
+        const float *floats[] = {e->speed, e->fx, e->prev_x};
+        for (int k=0;k<3;k++) for (int i=0;i<e->count;i++) fprintf(f, "%af, ", floats[k][i]);
+        fprintf(f, "0};\nconst unsigned char baked%d_tiles[] = {\n    ", l);
+        for (int i=0;i<cells;i++) fprintf(f, "%d,%s", world.tile_kind[i], i % 32 == 31 ? "\n    " : "");
+        fprintf(f, "0\n};\n");
+        SDL_FPoint at = player_start(&world);
+        const LevelSize ls = {world.grid_cols, world.grid_rows, world.width / TILE, world.solids_cap,
+                              {world.coins.cap, world.enemies.cap, world.mush.cap, world.goal_exists}, 0};
+        SDL_Rect g = world.goal_rect;
+        fprintf(f, "const BakedLevel baked%d = {{%d, %d, %d, %d, {%d, %d, %d, %d}, 0}, %d, %d, %d, %d,\n"
+                   "    baked%d_ints, baked%d_floats, baked%d_tiles, {%d, %d, %d, %d}, %d, {%af, %af}};\n\n",
+                l, ls.cols, ls.rows, ls.world_cols, ls.tiles, ls.spawns[0], ls.spawns[1], ls.spawns[2], ls.spawns[3],
+                world.coins.count, world.enemies.count, world.mush.count, world.solids_count, l, l, l,
+                g.x, g.y, g.w, g.h, world.goal_exists, at.x, at.y);
+    }
+    fprintf(f, "const BakedLevel *const BAKED_LEVELS[BAKED_LEVEL_COUNT] = {");
+    for (int l=0;l<NUM_LEVELS;l++) fprintf(f, "%s&baked%d", l ? ", " : "", l);
+    fprintf(f, "};\n");
+    arena_free(&world.arena);
+    return fclose(f) == 0;
+}
+
+int same_ints(const int *a, const int *b, int n) { return memcmp(a, b, n * sizeof(int)) == 0; }
+
+/* what a level build leaves in a World (the arrays, not the arena's
+   alignment padding, which is never written) */
+int same_level(const World *a, const World *b) {
+    const CoinStore *ca = &a->coins, *cb = &b->coins;
+    const EnemyStore *ea = &a->enemies, *eb = &b->enemies;
+    const MushStore *ma = &a->mush, *mb = &b->mush;
+    int cells = a->grid_cols * a->grid_rows, n = ea->count;
+    if (ca->count != cb->count || n != eb->count || ma->count != mb->count || a->solids_count != b->solids_count
+        || a->state_bytes != b->state_bytes || a->width != b->width || a->grid_cols != b->grid_cols || a->grid_rows != b->grid_rows
+        || a->goal_exists != b->goal_exists || memcmp(&a->goal_rect, &b->goal_rect, sizeof(SDL_Rect)) != 0) return 0;
+    return same_ints(ca->x, cb->x, ca->count) && same_ints(ca->y, cb->y, ca->count) && same_ints(ca->w, cb->w, ca->count) && same_ints(ca->h, cb->h, ca->count)
+        && same_ints(ea->x, eb->x, n) && same_ints(ea->y, eb->y, n) && same_ints(ea->w, eb->w, n) && same_ints(ea->h, eb->h, n) && same_ints(ea->dir, eb->dir, n)
+        && memcmp(ea->speed, eb->speed, n * sizeof(float)) == 0 && memcmp(ea->fx, eb->fx, n * sizeof(float)) == 0 && memcmp(ea->prev_x, eb->prev_x, n * sizeof(float)) == 0
+        && same_ints(ma->x, mb->x, ma->count) && same_ints(ma->y, mb->y, ma->count) && same_ints(ma->w, mb->w, ma->count) && same_ints(ma->h, mb->h, ma->count)
+        && memcmp(a->solids, b->solids, a->solids_count * sizeof(SDL_Rect)) == 0
+        && same_ints(a->solid_grid, b->solid_grid, cells) && memcmp(a->tile_kind, b->tile_kind, cells) == 0;
+}
+
+/* --check-baked: every baked level must build the same world as parsing
+   its map; 0 if one differs or the tables are stale */
+int check_baked_levels(void) {
+    int ok = 1;
+    for (int l=0;l<NUM_LEVELS;l++){
+        const BakedLevel *b = baked_level(l);
+        if (!b) { fprintf(stderr, "level %d: no usable baked tables\n", l + 1); ok = 0; continue; }
+        World baked = {0}, parsed = {0};
+        apply_baked(&baked, b);
+        build_level(&parsed, LEVELS[l], 8);
+        SDL_FPoint bs = player_start(&baked), ps = player_start(&parsed);
+        int same = same_level(&baked, &parsed) && bs.x == ps.x && bs.y == ps.y;
+        printf("level %d: %s\n", l + 1, same ? "baked tables match" : "baked tables DIFFER from the map");
+        ok = ok && same;
+        arena_free(&baked.arena);
+        arena_free(&parsed.arena);
+    }
+    return ok;
+}
+
+/* ---------------- TELEMETRY ----------------
+   Gameplay events (coins, mushrooms, stomps, hits, deaths, level clears)
+   for analytics, with --telemetry FILE. sim_tick pushes fixed-size records
+   into a single-producer / single-consumer ring of two atomic counters and
+   no locks; when the ring is full the event is dropped and counted rather
+   than waited for. A writer thread drains the ring in batches into the log:
+   a TelFileHeader, then one TelRecord per event, all little-endian. Only
+   the thread running sim_tick may push, so batch and rollback games leave
+   tel NULL. */
+enum {TEL_COIN, TEL_MUSH, TEL_STOMP, TEL_HIT, TEL_DEATH, TEL_CLEAR};
+#define TEL_RING 4096           /* records, a power of two */
+#define TEL_BATCH 512           /* records per write */
+#define TEL_IDLE_MS 20          /* writer sleep when the ring is empty */
+#define TEL_FILE_VERSION 2
+
+typedef struct {
+    Uint32 time_ms;     /* simulated time since the level (re)started */
+    Uint16 level;       /* level index */
+    Uint8 type;         /* TEL_* */
+    Uint8 arg;          /* TEL_MUSH: 1 if it made the player big; TEL_DEATH: 0 enemy, 1 fall, 2 time */
+    Sint32 x, y;        /* player position after the event */
+    Sint32 score;
+} TelRecord;
+
+typedef struct {
+    char magic[4];          /* "RPTE" */
+    Uint32 version;
+    Uint32 record_size;     /* sizeof(TelRecord) */
+} TelFileHeader;
+
+typedef struct Telemetry {
+    TelRecord ring[TEL_RING];
+    SDL_atomic_t head;      /* records pushed; stored by the producer only */
+    SDL_atomic_t tail;      /* records taken; stored by the writer only */
+    SDL_atomic_t stop;
+    long dropped;           /* producer only */
+    long written;           /* writer only */
+    FILE *f;
+    SDL_Thread *thread;
+} Telemetry;
+
+/* producer side; never blocks */
+void tel_push(Telemetry *t, const TelRecord *r) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&t->head);
+    if (head - (Uint32)SDL_AtomicGet(&t->tail) >= TEL_RING) { t->dropped++; return; }
+    t->ring[head & (TEL_RING - 1)] = *r;
+    SDL_AtomicSet(&t->head, (int)(head + 1));   /* publishes the record */
+}
+
+void tel_event(Game *g, int type, int arg) {
+    if (!g->tel) return;
+    const Player *p = &g->player;
+    TelRecord r = {(Uint32)(g->level_clock * 1000.0f), (Uint16)g->level_idx, (Uint8)type, (Uint8)arg,
+                   (Sint32)roundf(p->r.x), (Sint32)roundf(p->r.y), p->score};
+    tel_push(g->tel, &r);
+}
+
+int tel_writer_main(void *arg) {
+    Telemetry *t = arg;
+    TelRecord batch[TEL_BATCH];
+    for (;;) {
+        /* stop is read before head, so the last pass sees every push made before it */
+        int stopping = SDL_AtomicGet(&t->stop);
+        Uint32 tail = (Uint32)SDL_AtomicGet(&t->tail);
+        Uint32 n = (Uint32)SDL_AtomicGet(&t->head) - tail;
+        if (n > TEL_BATCH) n = TEL_BATCH;
+        for (Uint32 i=0;i<n;i++){
+            TelRecord r = t->ring[(tail + i) & (TEL_RING - 1)];
+            r.time_ms = SDL_SwapLE32(r.time_ms);
+            r.level = SDL_SwapLE16(r.level);
+            r.x = (Sint32)SDL_SwapLE32((Uint32)r.x);
+            r.y = (Sint32)SDL_SwapLE32((Uint32)r.y);
+            r.score = (Sint32)SDL_SwapLE32((Uint32)r.score);
+            batch[i] = r;
+        }
+        SDL_AtomicSet(&t->tail, (int)(tail + n));   /* frees the slots */
+        if (n > 0) t->written += (long)fwrite(batch, sizeof(TelRecord), n, t->f);
+        if (n == TEL_BATCH) continue;
+        if (stopping) break;
+        SDL_Delay(TEL_IDLE_MS);
+    }
+    return 0;
+}
+
+Telemetry *tel_open(const char *path) {
+    Telemetry *t = calloc(1, sizeof(Telemetry));
+    if (!t) return NULL;
+    t->f = fopen(path, "wb");
+    TelFileHeader h = {{'R','P','T','E'}, SDL_SwapLE32(TEL_FILE_VERSION), SDL_SwapLE32((Uint32)sizeof(TelRecord))};
+    if (!t->f || fwrite(&h, sizeof(h), 1, t->f) != 1) {
+        if (t->f) fclose(t->f);
+        free(t);
+        return NULL;
+    }
+    t->thread = SDL_CreateThread(tel_writer_main, "telemetry", t);
+    if (!t->thread) { fclose(t->f); free(t); return NULL; }
+    return t;
+}
+
+/* drain what is left, then close the log */
+void tel_close(Telemetry *t) {
+    SDL_AtomicSet(&t->stop, 1);
+    SDL_WaitThread(t->thread, NULL);
+    if (fclose(t->f) != 0) fprintf(stderr, "telemetry: write failed\n");
+    if (t->dropped) fprintf(stderr, "telemetry: %ld events written, %ld dropped (ring full)\n", t->written, t->dropped);
+    free(t);
+}
+
+/* ---------------- SIMULATION step ---------------- */
+/* player controls for one tick; the same struct is fed from the keyboard
+   or from a replay script */
+typedef struct {
+    int left, right;
+    int jump;   /* jump pressed since the previous tick */
+} Input;
+
+/* the player's rect as the integer rect pickups and enemies test against */
+SDL_Rect player_rect(const Player *p) {
+    return (SDL_Rect){(int)roundf(p->r.x),(int)roundf(p->r.y),(int)roundf(p->r.w),(int)roundf(p->r.h)};
+}
+
+/* Advance STATE_PLAY by one fixed tick of dt seconds. */
+void sim_tick(Game *g, Input in, float dt) {
+    Player *pl = &g->player;
+    World *world = &g->world;
+    float k = dt * TUNING_HZ;   /* 1.0 at the tuning rate */
+    if (world->pages) {
+        /* page in everything this tick can touch: the active region, with a
+           chunk of slack for the player and camera moving during the tick */
+        int wx0, wx1;
+        active_region(camera_x(world, pl->r.x + pl->r.w/2), &wx0, &wx1);
+        tile_pages_window(world, wx0 - CHUNK_W, wx1 + CHUNK_W);
+    }
+    pl->prev.x = pl->r.x; pl->prev.y = pl->r.y;
+    if (in.jump && pl->on_ground) pl->vy = JUMP_VEL * (pl->big ? 0.95f : 1.0f);
+    /* input horizontal */
+    float ax = 0;
+    if (in.left) ax -= 0.9f;
+    if (in.right) ax += 0.9f;
+    pl->vx += ax * k;
+    if (pl->vx > MAX_XSPEED) pl->vx = MAX_XSPEED;
+    if (pl->vx < -MAX_XSPEED) pl->vx = -MAX_XSPEED;
+    /* gravity */
+    pl->vy += GRAVITY * k;
+    if (pl->vy > 20) pl->vy = 20;
+    /* collisions */
+    prof_begin(PROF_COLLIDE);
+    resolve_horz_collision(world, pl, pl->vx * k);
+    resolve_vert_collision(world, pl, pl->vy * k);
+    prof_end(PROF_COLLIDE);
+    /* friction */
+    if (pl->on_ground && fabsf(pl->vx) > 0.01f) { pl->vx *= powf(0.82f, k); if (fabsf(pl->vx) < 0.1f) pl->vx = 0; }
+
+    /* coins near the player (after a pickup, slot i holds the next coin, so rescan from i) */
+    prof_begin(PROF_PICKUPS);
+    SDL_Rect pr = player_rect(pl);
+    int lo, hi;
+    store_span(world->coins.x, world->coins.count, pr.x, pr.x + pr.w, &lo, &hi);
+    for (int i = overlap_next(pr, world->coins.x, world->coins.y, world->coins.w, world->coins.h, lo, hi); i < hi;
+             i = overlap_next(pr, world->coins.x, world->coins.y, world->coins.w, world->coins.h, i, hi)){
+        remove_coin(world, i);
+        hi--;
+        pl->coins++;
+        pl->score += 100;
+        tel_event(g, TEL_COIN, 0);
+    }
+    /* mushrooms */
+    store_span(world->mush.x, world->mush.count, pr.x, pr.x + pr.w, &lo, &hi);
+    for (int i = overlap_next(pr, world->mush.x, world->mush.y, world->mush.w, world->mush.h, lo, hi); i < hi;
+             i = overlap_next(pr, world->mush.x, world->mush.y, world->mush.w, world->mush.h, i, hi)){
+        remove_mush(world, i);
+        hi--;
+        if (!pl->big) {
+            /* grow */
+            pl->big = 1;
+            pl->r.h += TILE/2;
+            pl->r.y -= TILE/2;
+            pl->big_timer = 12.0f;
+            pl->score += 500;
+            pr = player_rect(pl);
+            tel_event(g, TEL_MUSH, 1);
+        } else {
+            /* already big -> give points */
+            pl->score += 200;
+            tel_event(g, TEL_MUSH, 0);
+        }
+    }
+    prof_end(PROF_PICKUPS);
+    /* enemies update, in the active region only */
+    prof_begin(PROF_ENEMIES);
+    int ax0, ax1, mlo, mhi;
+    active_region(camera_x(world, pl->r.x + pl->r.w/2), &ax0, &ax1);
+    store_span(world->enemies.x, world->enemies.count, ax0, ax1, &lo, &hi);
+    update_enemies(world, lo, hi, dt);
+    store_span(world->enemies.x, world->enemies.count, ax0, ax1, &lo, &hi);
+    store_span(world->mush.x, world->mush.count, ax0, ax1, &mlo, &mhi);
+    broadphase_update(world, lo, hi, mlo, mhi);
+    broadphase_sweep(world, entity_pair);
+    prof_end(PROF_ENEMIES);
+    /* interactions with enemies */
+    prof_begin(PROF_PICKUPS);
+    pr = player_rect(pl);
+    store_span(world->enemies.x, world->enemies.count, pr.x, pr.x + pr.w, &lo, &hi);
+    for (int i = overlap_next(pr, world->enemies.x, world->enemies.y, world->enemies.w, world->enemies.h, lo, hi); i < hi;
+             i = overlap_next(pr, world->enemies.x, world->enemies.y, world->enemies.w, world->enemies.h, i, hi)){
+        SDL_Rect er = enemy_rect(world, i);
+        /* stomp if falling and near top */
+        if (pl->vy > 0 && (pl->r.y + pl->r.h) - er.y < 16.0f) {
+            remove_enemy(world, i);   /* rescan slot i, now holding the next enemy */
+            hi--;
+            pl->vy = JUMP_VEL * 0.6f;
+            pl->score += 200;
+            tel_event(g, TEL_STOMP, 0);
+            continue;
+        }
+        if (pl->big) {
+            /* shrink */
+            pl->big = 0;
+            pl->r.h -= TILE/2;
+            pl->r.y += TILE/2;
+            tel_event(g, TEL_HIT, 0);
+        } else {
+            /* lose life and respawn */
+            lose_life(g);
+            tel_event(g, TEL_DEATH, 0);
+        }
+        pr = player_rect(pl);
+        i++;
+    }
+    prof_end(PROF_PICKUPS);
+    /* fall off screen */
+    if (pl->r.y > SCREEN_H + 200) {
+        lose_life(g);
+        tel_event(g, TEL_DEATH, 1);
+    }
+    /* check flag / goal */
+    if (world->goal_exists) {
+        SDL_Rect gr = world->goal_rect;
+        if (aabb_int(player_rect(pl), gr)) {
+            g->state = STATE_LEVEL_CLEAR;
+            tel_event(g, TEL_CLEAR, 0);
+        }
+    }
+    /* big timer */
+    if (pl->big) {
+        pl->big_timer -= dt;
+        if (pl->big_timer <= 0) {
+            pl->big = 0;
+            pl->r.h -= TILE/2;
+            pl->r.y += TILE/2;
+        }
+    }
+    /* level timer */
+    g->level_clock += dt;
+    int time_left = g->level_time - (int)g->level_clock;
+    if (time_left <= 0) {
+        /* out of time: lose a life and reset level start time */
+        lose_life(g);
+        tel_event(g, TEL_DEATH, 2);
+        g->level_clock = 0;
+    }
+}
+
+/* ---------------- LIBRARY API ----------------
+   The simulation without a window. Each Game owns its World, so separate
+   Games can be stepped from different threads at once (call jobs_init
+   first to get a worker pool). game_step runs one tick at sim_hz and
+   answers menus the way the headless runner does: a cleared level goes
+   on to the next, and a finished game restarts from level 1.
+   Observations are OBS_SIZE floats: player x (over the level width),
+   y, vx, vy, on_ground, big, time left (fraction), goal dx, then dx/dy of
+   the OBS_NEAREST nearest enemies and coins (1, 1 when there are fewer),
+   offsets scaled by the screen size. */
+#define OBS_NEAREST 4
+#define OBS_SIZE (8 + 4 * OBS_NEAREST)
+
+Game *game_create(void) {
+    Game *g = calloc(1, sizeof(Game));
+    if (!g) return NULL;
+    g->player.r.w = TILE-12; g->player.r.h = TILE-8;
+    game_restart(g);
+    return g;
+}
+
+void game_destroy(Game *g) {
+    if (!g) return;
+    game_free(g);
+    free(g);
+}
+
+/* one tick; returns the score gained and sets *done when a game ended */
+int game_step(Game *g, Input in, int *done) {
+    int score = g->player.score;
+    *done = 0;
+    sim_tick(g, in, 1.0f / sim_hz);
+    int gained = g->player.score - score;
+    if (g->state == STATE_LEVEL_CLEAR) game_enter(g);
+    if (g->state == STATE_GAME_OVER || g->state == STATE_WIN) {
+        *done = 1;
+        game_restart(g);
+    }
+    return gained;
+}
+
+/* keep out[0..k) as the k smallest-distance (dx, dy) seen so far */
+void obs_nearest(float *out, float *dist, int k, float dx, float dy) {
+    float d = dx*dx + dy*dy;
+    if (d >= dist[k-1]) return;
+    int j = k - 1;
+    while (j > 0 && dist[j-1] > d) {
+        dist[j] = dist[j-1]; out[2*j] = out[2*(j-1)]; out[2*j+1] = out[2*(j-1)+1];
+        j--;
+    }
+    dist[j] = d; out[2*j] = dx; out[2*j+1] = dy;
+}
+
+void game_observe(const Game *g, float *obs) {
+    const World *world = &g->world;
+    const Player *p = &g->player;
+    float cx = p->r.x + p->r.w/2, cy = p->r.y + p->r.h/2;
+    obs[0] = world->width > 0 ? p->r.x / world->width : 0;
+    obs[1] = p->r.y / SCREEN_H;
+    obs[2] = p->vx / MAX_XSPEED;
+    obs[3] = p->vy / 20.0f;
+    obs[4] = (float)p->on_ground;
+    obs[5] = (float)p->big;
+    obs[6] = g->level_time > 0 ? (g->level_time - g->level_clock) / g->level_time : 0;
+    obs[7] = world->goal_exists ? (world->goal_rect.x - cx) / SCREEN_W : 1;
+    float *en = obs + 8, *co = obs + 8 + 2*OBS_NEAREST;
+    float en_d[OBS_NEAREST], co_d[OBS_NEAREST];
+    for (int i=0;i<OBS_NEAREST;i++){
+        en[2*i] = en[2*i+1] = co[2*i] = co[2*i+1] = 1;
+        en_d[i] = co_d[i] = 2;   /* (1, 1) */
+    }
+    for (int i=0;i<world->enemies.count;i++){
+        SDL_Rect r = enemy_rect(world, i);
+        obs_nearest(en, en_d, OBS_NEAREST, (r.x + r.w/2 - cx) / SCREEN_W, (r.y + r.h/2 - cy) / SCREEN_W);
+    }
+    for (int i=0;i<world->coins.count;i++){
+        SDL_Rect r = coin_rect(world, i);
+        obs_nearest(co, co_d, OBS_NEAREST, (r.x + r.w/2 - cx) / SCREEN_W, (r.y + r.h/2 - cy) / SCREEN_W);
+    }
+}
+
+/* ---------------- BATCH runner ----------------
+   batch_step advances n Games by one tick each over the job pool,
+   BATCH_GRAIN Games per claimed chunk: actions[i] drives games[i], which
+   writes OBS_SIZE floats at obs + i*OBS_SIZE, rewards[i] (score gained)
+   and dones[i]. Any of obs, rewards, dones may be NULL. Inside a batch,
+   each Game's own enemy update runs serially (the pool is busy). */
+#define BATCH_GRAIN 8
+
+typedef struct {
+    Game **games;
+    const Input *actions;
+    float *obs;
+    float *rewards;
+    int *dones;
+} BatchJob;
+
+void batch_step_range(int begin, int end, void *ctx) {
+    const BatchJob *b = ctx;
+    for (int i=begin;i<end;i++){
+        int done;
+        int reward = game_step(b->games[i], b->actions[i], &done);
+        if (b->rewards) b->rewards[i] = (float)reward;
+        if (b->dones) b->dones[i] = done;
+        if (b->obs) game_observe(b->games[i], b->obs + (size_t)i * OBS_SIZE);
+    }
+}
+
+void batch_step(Game **games, int n, const Input *actions, float *obs, float *rewards, int *dones) {
+    BatchJob job = {games, actions, obs, rewards, dones};
+    parallel_for(n, BATCH_GRAIN, batch_step_range, &job);
+}
+
+/* ---------------- HEADLESS replay ----------------
+   --headless [SCRIPT] runs the same sim_tick with no window or renderer,
+   fed from a recorded input script as fast as the CPU allows, and prints
+   ticks/s plus a checksum of the final state, so physics changes can be
+   benchmarked and checked for determinism without a display.
+   Script lines are "<ticks> <keys>" where keys is any of L, R, J or '.':
+   L/R are held for the whole span, J presses jump on its first tick.
+   Text after '#' is ignored. Without SCRIPT a built-in run is used. */
+typedef struct {
+    int ticks;
+    Input in;
+} InputSpan;
+#define MAX_SCRIPT_SPANS 4096
+InputSpan input_script[MAX_SCRIPT_SPANS];
+int input_script_len = 0;
+
+int load_input_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "cannot open input script %s\n", path); return 0; }
+    char line[256];
+    input_script_len = 0;
+    while (fgets(line, sizeof(line), f) && input_script_len < MAX_SCRIPT_SPANS) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        int ticks;
+        char keys[64] = ".";
+        if (sscanf(line, "%d %63s", &ticks, keys) < 1 || ticks <= 0) continue;
+        InputSpan *sp = &input_script[input_script_len++];
+        sp->ticks = ticks;
+        sp->in.left = strchr(keys, 'L') != NULL;
+        sp->in.right = strchr(keys, 'R') != NULL;
+        sp->in.jump = strchr(keys, 'J') != NULL;
+    }
+    fclose(f);
+    if (input_script_len == 0) { fprintf(stderr, "input script %s has no spans\n", path); return 0; }
+    return 1;
+}
+
+void load_builtin_script(void) {
+    /* run right, hopping every so often, with a short back-step */
+    static const InputSpan demo[] = {
+        {90, {0,1,0}}, {1, {0,1,1}}, {50, {0,1,0}}, {1, {0,1,1}}, {70, {0,1,0}},
+        {30, {1,0,0}}, {1, {0,1,1}}, {120, {0,1,0}}, {1, {0,0,1}}, {40, {0,0,0}},
+    };
+    input_script_len = (int)(sizeof(demo) / sizeof(demo[0]));
+    memcpy(input_script, demo, sizeof(demo));
+}
+
+/* hash of all mutable simulation state */
+Uint64 game_checksum(const Game *g) {
+    const World *world = &g->world;
+    Uint64 h = 14695981039346656037ULL;
+    h = fnv1a(h, &g->state, sizeof(g->state));
+    h = fnv1a(h, &g->level_idx, sizeof(g->level_idx));
+    h = fnv1a(h, &g->level_clock, sizeof(g->level_clock));
+    h = fnv1a(h, &g->player, sizeof(g->player));
+    h = fnv1a(h, &world->coins.count, sizeof(int));
+    h = fnv1a(h, world->coins.x, sizeof(int) * world->coins.count);
+    h = fnv1a(h, world->coins.y, sizeof(int) * world->coins.count);
+    h = fnv1a(h, &world->mush.count, sizeof(int));
+    h = fnv1a(h, world->mush.x, sizeof(int) * world->mush.count);
+    h = fnv1a(h, world->mush.y, sizeof(int) * world->mush.count);
+    h = fnv1a(h, &world->enemies.count, sizeof(int));
+    h = fnv1a(h, world->enemies.x, sizeof(int) * world->enemies.count);
+    h = fnv1a(h, world->enemies.dir, sizeof(int) * world->enemies.count);
+    h = fnv1a(h, world->enemies.fx, sizeof(float) * world->enemies.count);
+    return h;
+}
+
+/* max_ticks <= 0 plays the script once; otherwise the script loops.
+   rollback > 0 adds, before every real tick, a speculative run of that
+   many ticks that is then undone from a snapshot, the way rollback netplay
+   predicts ahead; the final checksum must match a run without it. */
+int run_headless(const char *script_path, long max_ticks, int rollback) {
+    if (script_path) {
+        if (!load_input_script(script_path)) return 1;
+    } else {
+        load_builtin_script();
+    }
+    if (max_ticks <= 0) {
+        max_ticks = 0;
+        for (int i=0;i<input_script_len;i++) max_ticks += input_script[i].ticks;
+    }
+    Game game = {0};
+    game.player.r.w = TILE-12; game.player.r.h = TILE-8;
+    game_restart(&game);
+
+    const float dt = 1.0f / sim_hz;
+    long ticks = 0, levels_cleared = 0, games = 1;
+    int span = 0, span_tick = 0;
+    long rollbacks = 0;
+    Snapshot snap = {0};
+    Uint64 t_start = SDL_GetPerformanceCounter();
+    while (ticks < max_ticks) {
+        Input in = input_script[span].in;
+        if (span_tick > 0) in.jump = 0;
+        if (rollback > 0 && snapshot_take(&game, &snap)) {
+            for (int i=0;i<rollback && game.state == STATE_PLAY;i++) sim_tick(&game, in, dt);
+            if (!snapshot_restore(&game, &snap)) { fprintf(stderr, "headless: snapshot restore failed\n"); return 1; }
+            rollbacks++;
+        }
+        sim_tick(&game, in, dt);
+        ticks++;
+        if (++span_tick >= input_script[span].ticks) {
+            span_tick = 0;
+            span = (span + 1) % input_script_len;
+        }
+        /* menus are answered immediately, as if Enter were pressed */
+        if (game.state == STATE_LEVEL_CLEAR) {
+            levels_cleared++;
+            game_enter(&game);
+        }
+        if (game.state == STATE_GAME_OVER || game.state == STATE_WIN) {
+            games++;
+            game_restart(&game);
+        }
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - t_start) / SDL_GetPerformanceFrequency();
+    printf("headless: %ld ticks at %d Hz in %.3f s (%.0f ticks/s)\n", ticks, sim_hz, secs, secs > 0 ? ticks / secs : 0.0);
+    printf("headless: games %ld, levels cleared %ld, level %d, score %d, coins %d, lives %d\n",
+           games, levels_cleared, game.level_idx + 1, game.player.score, game.player.coins, game.player.lives);
+    if (rollback > 0) {
+        printf("headless: %ld rollbacks of %d ticks, %zu-byte snapshots (%.0f take+restore/s incl. resim)\n",
+               rollbacks, rollback, snap.size, secs > 0 ? rollbacks / secs : 0.0);
+    }
+    printf("headless: checksum %016llx\n", (unsigned long long)game_checksum(&game));
+    snapshot_free(&snap);
+    game_free(&game);
+    return 0;
+}
+
+/* --headless --batch N: n games, each driven by its own LCG (mostly run
+   right, sometimes back off or jump), for ticks steps; prints steps/s and
+   a checksum over every game, which must not depend on --threads */
+int run_batch(int n, long ticks) {
+    if (ticks <= 0) ticks = 10000;
+    Game **games = calloc(n, sizeof(Game *));
+    Input *actions = calloc(n, sizeof(Input));
+    float *obs = malloc((size_t)n * OBS_SIZE * sizeof(float));
+    float *rewards = malloc(n * sizeof(float));
+    int *dones = malloc(n * sizeof(int));
+    Uint32 *rng = malloc(n * sizeof(Uint32));
+    if (!games || !actions || !obs || !rewards || !dones || !rng) { fprintf(stderr, "batch: out of memory\n"); return 1; }
+    for (int i=0;i<n;i++){
+        games[i] = game_create();
+        if (!games[i]) { fprintf(stderr, "batch: out of memory\n"); return 1; }
+        rng[i] = 2463534242u + (Uint32)i * 2654435761u;
+    }
+    double total_reward = 0;
+    long episodes = 0;
+    Uint64 t_start = SDL_GetPerformanceCounter();
+    for (long t=0;t<ticks;t++){
+        for (int i=0;i<n;i++){
+            rng[i] = rng[i] * 1664525u + 1013904223u;
+            Uint32 r = rng[i] >> 24;
+            actions[i].right = r < 200;
+            actions[i].left = r >= 230;
+            actions[i].jump = (r & 15) == 0;
+        }
+        batch_step(games, n, actions, obs, rewards, dones);
+        for (int i=0;i<n;i++){ total_reward += rewards[i]; episodes += dones[i]; }
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - t_start) / SDL_GetPerformanceFrequency();
+    double steps = (double)n * ticks;
+    Uint64 h = 14695981039346656037ULL;
+    for (int i=0;i<n;i++){
+        Uint64 c = game_checksum(games[i]);
+        h = fnv1a(h, &c, sizeof(c));
+    }
+    printf("batch: %d games x %ld ticks on %d threads in %.3f s (%.0f steps/s)\n",
+           n, ticks, job_worker_count + 1, secs, secs > 0 ? steps / secs : 0.0);
+    printf("batch: %ld episodes, total reward %.0f\n", episodes, total_reward);
+    printf("batch: checksum %016llx\n", (unsigned long long)h);
+    for (int i=0;i<n;i++) game_destroy(games[i]);
+    free(games); free(actions); free(obs); free(rewards); free(dones); free(rng);
+    return 0;
+}
+
+/* ---------------- ASSETS (background loading) ----------------
+   Everything slow at startup that needs no renderer runs on a loader
+   thread while the main thread creates the window and already presents
+   the title screen: the glyph atlas (from the font cache, or by opening
+   and rasterizing the font and then writing the cache), then with --levels
+   level 0 into the spare World (see LEVEL PREFETCH). The main thread polls
+   done once a frame, then uploads the atlas, takes the font and hands the
+   spare to the Game; until then it touches none of them, text is simply
+   not drawn, and Enter builds level 0 itself. */
+#define FONT_POINTS 18
+
+typedef struct {
+    const char *font_path;
+    const char *cache_path;     /* NULL: no cache */
+    TTF_Font *font;             /* opened only when the cache missed */
+    SDL_Surface *sheet;         /* atlas pixels, NULL if there is no text */
+    GlyphAtlas metrics;
+    int from_cache;
+    LevelPrefetch *level;       /* build level 0 into this, or NULL */
+    double ms;                  /* time the loader took */
+    SDL_atomic_t done;
+} AssetLoad;
+
+int asset_loader_main(void *arg) {
+    AssetLoad *al = arg;
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    if (al->cache_path) al->sheet = font_cache_load(al->cache_path, al->font_path, FONT_POINTS, &al->metrics);
+    al->from_cache = al->sheet != NULL;
+    if (!al->sheet) {
+        /* if the font is missing we continue without text */
+        al->font = TTF_OpenFont(al->font_path, FONT_POINTS);
+        if (al->font) al->sheet = atlas_rasterize(al->font, &al->metrics);
+        if (al->sheet && al->cache_path && !font_cache_save(al->cache_path, al->font_path, FONT_POINTS, &al->metrics, al->sheet))
+            fprintf(stderr, "cannot write font cache %s\n", al->cache_path);
+    }
+    if (al->level) level_prefetch_build(al->level);
+    al->ms = (double)(SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency();
+    SDL_AtomicSet(&al->done, 1);
+    /* wake the main loop if it is idling in SDL_WaitEventTimeout */
+    SDL_Event wake;
+    memset(&wake, 0, sizeof(wake));
+    wake.type = SDL_USEREVENT;
+    SDL_PushEvent(&wake);
+    return 0;
+}
+
+/* ---------------- FRAME pacing ----------------
+   PACE_VSYNC lets SDL_RenderPresent block on the display and adds no wait
+   of its own. PACE_CAP waits for a fixed schedule on the performance
+   counter, sleeping until PACE_SPIN_MS before the deadline and spinning
+   the rest, since SDL_Delay alone can oversleep by a scheduler tick.
+   PACE_UNCAPPED never waits. Recent frame times are kept for the F3
+   overlay (mean, jitter, worst, frames over 1.5x the target). */
+enum {PACE_VSYNC, PACE_CAP, PACE_UNCAPPED};
+const char *PACE_NAMES[] = {"vsync", "cap", "uncapped"};
+#define PACE_SPIN_MS 2.0
+#define PACE_STATS_FRAMES 240
+/* Off STATE_PLAY (with the overlays hidden) nothing on screen moves, so a
+   frame is only drawn and presented when something may have changed it:
+   an event, a state change or the assets arriving. In between the loop
+   sleeps in SDL_WaitEventTimeout instead of pacing frames; the timeout
+   only bounds how long it can sleep between checks. */
+#define IDLE_WAIT_MS 250
+
+typedef struct {
+    int mode;               /* PACE_* */
+    int fps;                /* target rate, also the reference for missed frames */
+    Uint64 freq, period;    /* counter ticks per second / per frame */
+    Uint64 deadline;        /* earliest start of the next frame (PACE_CAP) */
+    float times[PACE_STATS_FRAMES];   /* recent frame times, ms */
+    int count;              /* frames recorded */
+} Pacer;
+
+void pace_init(Pacer *p, int mode, int fps) {
+    memset(p, 0, sizeof(*p));
+    p->mode = mode;
+    p->fps = fps > 0 ? fps : FPS;
+    p->freq = SDL_GetPerformanceFrequency();
+    p->period = p->freq / p->fps;
+}
+
+/* block until the next frame may start */
+void pace_wait(Pacer *p) {
+    if (p->mode != PACE_CAP) return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    /* first frame, or a whole frame late: restart the schedule rather than
+       rushing extra frames out to catch up */
+    if (p->deadline == 0 || now > p->deadline + p->period) p->deadline = now;
+    while (now < p->deadline) {
+        double left_ms = (double)(p->deadline - now) * 1000.0 / p->freq;
+        if (left_ms > PACE_SPIN_MS) SDL_Delay((Uint32)(left_ms - PACE_SPIN_MS));
+        now = SDL_GetPerformanceCounter();
+    }
+    p->deadline += p->period;
+}
+
+void pace_record(Pacer *p, double frame_ms) {
+    p->times[p->count % PACE_STATS_FRAMES] = (float)frame_ms;
+    p->count++;
+}
+
+void pace_stats(const Pacer *p, float *mean, float *jitter, float *worst, int *missed) {
+    int n = p->count < PACE_STATS_FRAMES ? p->count : PACE_STATS_FRAMES;
+    double sum = 0, sq = 0;
+    float limit = 1.5f * 1000.0f / p->fps;
+    *worst = 0; *missed = 0;
+    for (int i=0;i<n;i++){
+        float t = p->times[i];
+        sum += t; sq += (double)t * t;
+        if (t > *worst) *worst = t;
+        if (t > limit) (*missed)++;
+    }
+    *mean = n ? (float)(sum / n) : 0;
+    double var = n ? sq / n - (sum / n) * (sum / n) : 0;
+    *jitter = var > 0 ? (float)sqrt(var) : 0;
+}
+
+/* ---------------- MAIN ---------------- */
+#ifndef RETRO_NO_MAIN
+int main(int argc, char **argv) {
+    int headless = 0;
+    const char *script_path = NULL;
+    long headless_ticks = 0;
+    int rollback = 0;
+    int batch = 0;
+    const char *prof_csv_path = NULL;
+    int pace_mode = PACE_VSYNC, pace_fps = FPS;
+    const char *font_path = "/usr/share/fonts/truetype/dejavu/DejaVuSans-Bold.ttf";
+    const char *font_cache_path = NULL;
+    const char *telemetry_path = NULL;
+    for (int i=1;i<argc;i++){
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+            if (i+1 < argc && strncmp(argv[i+1], "--", 2) != 0) script_path = argv[++i];
+        } else if (strcmp(argv[i], "--ticks") == 0 && i+1 < argc) {
+            headless_ticks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i+1 < argc) {
+            batch = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rollback") == 0 && i+1 < argc) {
+            rollback = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-merge") == 0) {
+            merge_solids = 0;
+        } else if (strcmp(argv[i], "--hz") == 0 && i+1 < argc) {
+            sim_hz = atoi(argv[++i]);
+            if (sim_hz < 10) sim_hz = 10;
+            if (sim_hz > 1000) sim_hz = 1000;
+        } else if (strcmp(argv[i], "--prof-csv") == 0 && i+1 < argc) {
+            prof_csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--levels") == 0 && i+1 < argc) {
+            level_dir = argv[++i];
+        } else if (strcmp(argv[i], "--pacing") == 0 && i+1 < argc) {
+            const char *m = argv[++i];
+            if (strcmp(m, "vsync") == 0) pace_mode = PACE_VSYNC;
+            else if (strcmp(m, "cap") == 0) pace_mode = PACE_CAP;
+            else if (strcmp(m, "uncapped") == 0) pace_mode = PACE_UNCAPPED;
+            else fprintf(stderr, "unknown pacing mode %s (vsync, cap, uncapped)\n", m);
+        } else if (strcmp(argv[i], "--fps") == 0 && i+1 < argc) {
+            pace_fps = atoi(argv[++i]);
+            if (pace_fps < 1) pace_fps = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+            job_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--font") == 0 && i+1 < argc) {
+            font_path = argv[++i];
+        } else if (strcmp(argv[i], "--font-cache") == 0 && i+1 < argc) {
+            font_cache_path = argv[++i];
+        } else if (strcmp(argv[i], "--sim-margin") == 0 && i+1 < argc) {
+            sim_margin = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i+1 < argc) {
+            telemetry_path = argv[++i];
+        } else if (strcmp(argv[i], "--compile-level") == 0 && i+2 < argc) {
+            return compile_level(argv[i+1], argv[i+2]) ? 0 : 1;
+        } else if (strcmp(argv[i], "--bake-levels") == 0 && i+1 < argc) {
+            return bake_levels(argv[i+1]) ? 0 : 1;
+        } else if (strcmp(argv[i], "--check-baked") == 0) {
+            return check_baked_levels() ? 0 : 1;
+        }
+    }
+    if (level_dir) {
+        num_levels = count_level_files();
+        if (num_levels == 0) { fprintf(stderr, "no level001.lvl/.txt in %s\n", level_dir); return 1; }
+    }
+    jobs_init();
+    if (headless) {
+        int rc = batch > 0 ? run_batch(batch, headless_ticks) : run_headless(script_path, headless_ticks, rollback);
+        jobs_shutdown();
+        return rc;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "SDL Init error: %s\n", SDL_GetError()); return 1;
+    }
+    if (TTF_Init() != 0) {
+        fprintf(stderr, "TTF Init error: %s\n", TTF_GetError()); SDL_Quit(); return 1;
+    }
+    Uint64 launch_counter = SDL_GetPerformanceCounter();
+
+    /* game state; the first level is built when Enter leaves the title */
+    Game game = {0};
+    game.state = STATE_TITLE;
+    Player *pl = &game.player;
+    World *world = &game.world;
+    pl->coins = 0; pl->score = 0; pl->lives = 3; pl->big = 0; pl->big_timer = 0;
+    pl->r.w = TILE-12; pl->r.h = TILE-8;
+
+    /* start loading before the window exists; window creation overlaps it */
+    char *pref_dir = font_cache_path ? NULL : SDL_GetPrefPath("retro", "platformer");
+    char default_cache[1024];
+    if (pref_dir) {
+        snprintf(default_cache, sizeof(default_cache), "%sfont.cache", pref_dir);
+        font_cache_path = default_cache;
+        SDL_free(pref_dir);
+    }
+    LevelPrefetch prefetch = {0};   /* want 0: the loader builds level 0 */
+    prefetch.idx = -1;
+    AssetLoad load = {0};
+    load.font_path = font_path;
+    load.cache_path = font_cache_path;
+    load.level = level_dir ? &prefetch : NULL;
+    SDL_Thread *loader = SDL_CreateThread(asset_loader_main, "assets", &load);
+    if (!loader) asset_loader_main(&load);
+    int assets_ready = 0;
+    double first_frame_ms = -1;
+    TTF_Font *font = NULL;
+
+    /* from here on every exit goes through shutdown, which joins the loader */
+    int rc = 0;
+    SDL_Renderer *ren = NULL;
+    SDL_Window *win = SDL_CreateWindow("Retro Platformer (C / SDL2)", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_W, SCREEN_H, 0);
+    if (!win) { fprintf(stderr, "CreateWindow failed: %s\n", SDL_GetError()); rc = 1; goto shutdown; }
+    ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | (pace_mode == PACE_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0));
+    if (!ren) { fprintf(stderr, "CreateRenderer failed: %s\n", SDL_GetError()); rc = 1; goto shutdown; }
+    /* only once there is a game to record, so a failed start leaves no empty log */
+    if (telemetry_path && !(game.tel = tel_open(telemetry_path)))
+        fprintf(stderr, "cannot open telemetry log %s\n", telemetry_path);
+    SDL_RendererInfo rinfo;
+    if (pace_mode == PACE_VSYNC && SDL_GetRendererInfo(ren, &rinfo) == 0 && !(rinfo.flags & SDL_RENDERER_PRESENTVSYNC)) {
+        /* no vsync from this renderer: pace ourselves instead of spinning */
+        pace_mode = PACE_CAP;
+    }
+    Pacer pacer;
+    pace_init(&pacer, pace_mode, pace_fps);
+
+    prof_on = 1;
+
+    int running = 1;
+    /* fixed-step accumulator: simulation runs at sim_hz regardless of frame rate */
+    const double step = 1.0 / sim_hz;
+    const Uint64 perf_freq = SDL_GetPerformanceFrequency();
+    Uint64 last_counter = SDL_GetPerformanceCounter();
+    double accumulator = 0;
+    int jump_pressed = 0;   /* latched until the next tick consumes it */
+    int dirty = 1;          /* the presented frame may be out of date */
+    int idle = 0;           /* on a static screen that is already presented */
+    int drawn_state = -1;   /* game.state of the presented frame */
+
+    while (running) {
+        if (idle) {
+            /* leaves the event queued for the poll below; the time slept is
+               not a frame, so it goes neither into the pacing stats nor the
+               accumulator */
+            SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS);
+            last_counter = SDL_GetPerformanceCounter();
+        } else {
+            pace_wait(&pacer);
+        }
+
+        Uint64 counter = SDL_GetPerformanceCounter();
+        double frame_time = (double)(counter - last_counter) / perf_freq;
+        last_counter = counter;
+        if (!idle) pace_record(&pacer, frame_time * 1000.0);
+        if (frame_time > MAX_FRAME_TIME) frame_time = MAX_FRAME_TIME;
+        accumulator += frame_time;
+        /* phases timed in the previous iteration belong to this interval */
+        prof_frame_end(frame_time * 1000.0);
+
+        if (!assets_ready && SDL_AtomicGet(&load.done)) {
+            if (loader) SDL_WaitThread(loader, NULL);
+            font = load.font;
+            if (load.sheet && !atlas_upload(ren, &load.metrics, load.sheet)) {
+                fprintf(stderr, "glyph atlas failed: %s\n", SDL_GetError());
+            }
+            if (load.level) game.prefetch = load.level;
+            assets_ready = 1;
+            dirty = 1;
+        }
+        level_prefetch_next(&game);
+
+        prof_begin(PROF_INPUT);
+        SDL_Event ev;
+        while (SDL_PollEvent(&ev)) {
+            if (ev.type == SDL_QUIT) { running = 0; }
+            else if (ev.type == SDL_RENDER_TARGETS_RESET || ev.type == SDL_RENDER_DEVICE_RESET) {
+                /* target texture contents were lost; re-bake on next draw */
+                invalidate_level_chunks();
+                dirty = 1;
+            }
+            else if (ev.type == SDL_WINDOWEVENT) {
+                /* exposed, resized, restored...: the window needs the frame again */
+                dirty = 1;
+            }
+            else if (ev.type == SDL_KEYDOWN) {
+                dirty = 1;
+                SDL_Keycode k = ev.key.keysym.sym;
+                if (k == SDLK_ESCAPE) { running = 0; }
+                if (k == SDLK_F3) show_stats = !show_stats;
+                if (k == SDLK_F4) show_prof = !show_prof;
+                if (k == SDLK_RETURN && game.state != STATE_PLAY) {
+                    game_enter(&game);
+                } else if (k == SDLK_r) {
+                    level_restart(&game);
+                } else if (k == SDLK_z || k == SDLK_SPACE || k == SDLK_UP) {
+                    if (game.state == STATE_PLAY) jump_pressed = 1;
+                }
+            }
+        }
+
+        const Uint8 *keystate = SDL_GetKeyboardState(NULL);
+        Input in = {0};
+        in.left = keystate[SDL_SCANCODE_LEFT] || keystate[SDL_SCANCODE_A];
+        in.right = keystate[SDL_SCANCODE_RIGHT] || keystate[SDL_SCANCODE_D];
+        prof_end(PROF_INPUT);
+        /* run as many fixed ticks as the elapsed time calls for */
+        int ticks = 0;
+        while (accumulator >= step && ticks < MAX_TICKS_PER_FRAME) {
+            if (game.state == STATE_PLAY) {
+                in.jump = jump_pressed;
+                sim_tick(&game, in, (float)step);
+                jump_pressed = 0;
+            }
+            accumulator -= step;
+            ticks++;
+        }
+        /* too far behind: drop the backlog rather than spiral */
+        if (accumulator >= step) accumulator = fmod(accumulator, step);
+        float alpha = (float)(accumulator / step);
+        /* off PLAY nothing ticks: show the final positions, so the frame
+           depends on the game state alone */
+        if (game.state != STATE_PLAY) alpha = 1.0f;
+
+        if (game.state == STATE_PLAY || game.state != drawn_state || show_stats || show_prof) dirty = 1;
+        /* the loading screen idles too: the loader's wake event or the
+           timeout brings the loop back to pick up the assets */
+        idle = game.state != STATE_PLAY && !show_stats && !show_prof;
+        if (!dirty) continue;
+        dirty = 0;
+        drawn_state = game.state;
+
+        /* render */
+        prof_begin(PROF_DRAW);
+        render_batches = 0;
+        SDL_SetRenderDrawColor(ren, SKY.r, SKY.g, SKY.b, SKY.a);
+        SDL_RenderClear(ren);
+
+        int state = game.state;
+        if (state == STATE_TITLE) {
+            /* simple title screen */
+            draw_rect(ren, 180, 100, 600, 80, (SDL_Color){255,255,255,255});
+            render_flush(ren);
+            prof_end(PROF_DRAW);
+            prof_begin(PROF_TEXT);
+            draw_cached_text(ren, font, "RETRO PLATFORMER (C / SDL2) - Press Enter to Start", HUD_COL, -1, 240);
+            prof_end(PROF_TEXT);
+        } else if (state == STATE_PLAY || state == STATE_LEVEL_CLEAR || state == STATE_GAME_OVER || state == STATE_WIN) {
+            /* interpolate between the last two ticks for smooth motion */
+            Player view = *pl;
+            view.r.x = pl->prev.x + (pl->r.x - pl->prev.x) * alpha;
+            view.r.y = pl->prev.y + (pl->r.y - pl->prev.y) * alpha;
+            /* camera */
+            int camx = camera_x(world, view.r.x + view.r.w/2);
+            /* background hills */
+            for (int i=-2;i<12;i++){
+                int bx = i*300 - (camx/2 % 600);
+                draw_rect(ren, bx, SCREEN_H-80, 220, 80, (SDL_Color){70,160,90,255});
+            }
+            /* draw level tiles */
+            memset(&cull_stats, 0, sizeof(cull_stats));
+            draw_level(ren, world, camx);
+            /* draw coins (the stores are x-sorted, so only the view's span is visited) */
+            int lo, hi;
+            cull_stats.coins_total = world->coins.count;
+            store_span(world->coins.x, world->coins.count, camx, camx + SCREEN_W, &lo, &hi);
+            for (int i=lo;i<hi;i++){
+                SDL_Rect r = coin_rect(world, i);
+                if (!on_screen(r, camx)) continue;
+                draw_coin(ren, r, camx);
+                cull_stats.coins_drawn++;
+            }
+            /* mushrooms */
+            cull_stats.mush_total = world->mush.count;
+            store_span(world->mush.x, world->mush.count, camx, camx + SCREEN_W, &lo, &hi);
+            for (int i=lo;i<hi;i++){
+                SDL_Rect r = mush_rect(world, i);
+                if (!on_screen(r, camx)) continue;
+                draw_mush(ren, r, camx);
+                cull_stats.mush_drawn++;
+            }
+            /* enemies */
+            cull_stats.enemies_total = world->enemies.count;
+            store_span(world->enemies.x, world->enemies.count, camx - TILE, camx + SCREEN_W + TILE, &lo, &hi);
+            for (int i=lo;i<hi;i++){
+                SDL_Rect r = enemy_rect(world, i);
+                r.x = (int)roundf(world->enemies.prev_x[i] + (world->enemies.fx[i] - world->enemies.prev_x[i]) * alpha);
+                if (!on_screen(r, camx)) continue;
+                draw_enemy(ren, r, camx);
+                cull_stats.enemies_drawn++;
+            }
+            /* flag (the cloth sticks out 38px right of the pole) */
+            if (world->goal_exists) {
+                SDL_Rect fr = world->goal_rect;
+                fr.w += 38;
+                if (on_screen(fr, camx)) draw_flag(ren, world->goal_rect, camx);
+            }
+            /* player */
+            draw_player(ren, &view, camx);
+            render_flush(ren);
+            prof_end(PROF_DRAW);
+
+            /* HUD */
+            prof_begin(PROF_TEXT);
+            if (atlas.tex) {
+                char buf[256];
+                int time_left = game.level_time - (int)game.level_clock;
+                snprintf(buf, sizeof(buf), "LEVEL %d    SCORE %06d    COINS %02d    LIVES %d    TIME %03d",
+                         game.level_idx+1, pl->score, pl->coins, pl->lives, time_left);
+                draw_text(ren, 12, 10, buf, HUD_COL);
+                if (show_stats) {
+                    CullStats *cs = &cull_stats;
+                    snprintf(buf, sizeof(buf), "VISIBLE  chunks %d/%d  solids %d/%d  coins %d/%d  mush %d/%d  enemies %d/%d",
+                             cs->chunks_drawn, cs->chunks_total, cs->solids_drawn, cs->solids_total, cs->coins_drawn, cs->coins_total,
+                             cs->mush_drawn, cs->mush_total, cs->enemies_drawn, cs->enemies_total);
+                    draw_text(ren, 12, 34, buf, HUD_COL);
+                    snprintf(buf, sizeof(buf), "DRAW  batches %d (last frame)  chunk bakes %d", last_render_batches, chunk_bakes);
+                    draw_text(ren, 12, 58, buf, HUD_COL);
+                    float mean, jitter, worst;
+                    int missed;
+                    pace_stats(&pacer, &mean, &jitter, &worst, &missed);
+                    snprintf(buf, sizeof(buf), "PACE  %s %d  frame %.2f ms  +-%.2f  worst %.2f  missed %d/%d",
+                             PACE_NAMES[pacer.mode], pacer.fps, mean, jitter, worst, missed,
+                             pacer.count < PACE_STATS_FRAMES ? pacer.count : PACE_STATS_FRAMES);
+                    draw_text(ren, 12, 82, buf, HUD_COL);
+                    snprintf(buf, sizeof(buf), "LOAD  assets %.1f ms (%s)  first frame %.1f ms",
+                             load.ms, load.from_cache ? "font cache" : "font", first_frame_ms);
+                    draw_text(ren, 12, 106, buf, HUD_COL);
+                    if (world->pages) {
+                        const TilePages *tp = world->pages;
+                        snprintf(buf, sizeof(buf), "GRID  %d pages for %d chunks  page-ins %d", tp->count, tp->chunks, tp->page_ins);
+                        draw_text(ren, 12, 130, buf, HUD_COL);
+                    }
+                }
+            }
+            /* small message if big */
+            if (pl->big && atlas.tex) {
+                const char *msg = "MUSHROOM: BIG!";
+                SDL_Color col = {10,10,10,255};
+                CachedText *t = cached_text(ren, font, msg, col);
+                draw_cached_text(ren, font, msg, col, SCREEN_W - (t ? t->w : text_width(msg)) - 12, 10);
+            }
+
+            if (state == STATE_LEVEL_CLEAR) {
+                draw_cached_text(ren, font, "COURSE CLEAR! Press Enter to continue", (SDL_Color){255,255,255,255}, -1, SCREEN_H/3);
+            } else if (state == STATE_GAME_OVER) {
+                draw_cached_text(ren, font, "GAME OVER - Press Enter to Restart", (SDL_Color){255,255,255,255}, -1, SCREEN_H/3);
+            } else if (state == STATE_WIN) {
+                draw_cached_text(ren, font, "YOU WIN! Thanks for playing", (SDL_Color){255,255,255,255}, -1, SCREEN_H/3);
+            }
+            prof_end(PROF_TEXT);
+        }
+        if (show_prof) draw_prof_overlay(ren);
+
+        prof_begin(PROF_PRESENT);
+        render_flush(ren);
+        last_render_batches = render_batches;
+        SDL_RenderPresent(ren);
+        prof_end(PROF_PRESENT);
+        if (first_frame_ms < 0) first_frame_ms = (double)(SDL_GetPerformanceCounter() - launch_counter) * 1000.0 / perf_freq;
+
+        /* simple state advancement: go to WIN when level cleared and last level was done */
+        if (state == STATE_LEVEL_CLEAR) {
+            /* nothing automatic; waiting for Enter key to continue (handled in event loop) */
+        }
 
     } /* main loop */
 
+    if (prof_csv_path) prof_write_csv(prof_csv_path);
+shutdown:
+    if (!assets_ready) {
+        /* the loader may still be in TTF_OpenFont or rasterizing */
+        if (loader) SDL_WaitThread(loader, NULL);
+        font = load.font;
+        if (load.sheet) SDL_FreeSurface(load.sheet);
+    }
+    level_prefetch_join(&prefetch);
+    world_free(&prefetch.world);
+
+    text_shutdown();
+    free_level_chunks();
+    if (game.tel) tel_close(game.tel);
+    game_free(&game);
+    jobs_shutdown();
     if (font) TTF_CloseFont(font);
-    SDL_DestroyRenderer(ren);
-    SDL_DestroyWindow(win);
+    if (ren) SDL_DestroyRenderer(ren);
+    if (win) SDL_DestroyWindow(win);
     TTF_Quit();
     SDL_Quit();
-    return 0;
+    return rc;
 }
+#endif /* RETRO_NO_MAIN */
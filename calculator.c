@@ -1,9 +1,139 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main() {
+/* Batch mode: calculator --batch [FILE]
+   Reads one "op num1 num2" per line from FILE (or stdin) and writes one
+   result line per input line, in the same format as the interactive mode.
+   Input is read in big blocks and output goes through one buffer, so a
+   whole file is one streaming pass instead of a process per line. */
+
+#define IN_BLOCK (1 << 16)
+#define OUT_BLOCK (1 << 16)
+
+typedef int (*OpFn)(double a, double b, double *result);
+
+int op_add(double a, double b, double *result) { *result = a + b; return 1; }
+int op_sub(double a, double b, double *result) { *result = a - b; return 1; }
+int op_mul(double a, double b, double *result) { *result = a * b; return 1; }
+int op_div(double a, double b, double *result) {
+    if (b == 0) return 0;
+    *result = a / b;
+    return 1;
+}
+
+/* indexed by the operator character; NULL means invalid operator */
+OpFn ops[256];
+
+void init_ops(void) {
+    ops['+'] = op_add;
+    ops['-'] = op_sub;
+    ops['*'] = op_mul;
+    ops['/'] = op_div;
+}
+
+char out_buf[OUT_BLOCK];
+size_t out_len = 0;
+
+void out_flush(void) {
+    fwrite(out_buf, 1, out_len, stdout);
+    out_len = 0;
+}
+
+void out_line(const char *s, int n) {
+    if (out_len + n > sizeof(out_buf)) out_flush();
+    memcpy(out_buf + out_len, s, n);
+    out_len += n;
+}
+
+/* evaluate one line (NUL-terminated, without its newline) */
+void eval_line(char *line) {
+    char buf[512];   /* "Result: " and a %.2lf of up to 1e308 fit */
+    char *p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == 0 || *p == '\r') return;   /* blank line */
+    unsigned char op = (unsigned char)*p++;
+    char *end;
+    double num1 = strtod(p, &end);
+    int ok = end != p;
+    p = end;
+    double num2 = strtod(p, &end);
+    ok = ok && end != p;
+    double result;
+    int n;
+    if (!ops[op])
+        n = snprintf(buf, sizeof(buf), "Invalid operator!\n");
+    else if (!ok)
+        n = snprintf(buf, sizeof(buf), "Invalid numbers!\n");
+    else if (!ops[op](num1, num2, &result))
+        n = snprintf(buf, sizeof(buf), "Error! Division by zero.\n");
+    else
+        n = snprintf(buf, sizeof(buf), "Result: %.2lf\n", result);
+    if (n < 0) return;
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;   /* snprintf gives the untruncated length */
+    out_line(buf, n);
+}
+
+int run_batch(FILE *in) {
+    /* one extra byte so the last line can always be NUL-terminated */
+    char *block = malloc(IN_BLOCK + 1);
+    if (!block) return 1;
+    size_t have = 0;   /* bytes of an unfinished line kept from the last read */
+    int skipping = 0;  /* inside a line longer than the block: drop it up to its newline */
+    for (;;) {
+        size_t got = fread(block + have, 1, IN_BLOCK - have, in);
+        size_t len = have + got;
+        if (len == 0) break;
+        size_t start = 0;
+        char *nl;
+        if (skipping) {
+            nl = memchr(block, '\n', len);
+            if (!nl) { have = 0; continue; }
+            start = nl - block + 1;
+            skipping = 0;
+        }
+        while ((nl = memchr(block + start, '\n', len - start)) != NULL) {
+            *nl = 0;
+            eval_line(block + start);
+            start = nl - block + 1;
+        }
+        have = len - start;
+        if (got == 0) {
+            /* end of input: the last line has no newline */
+            block[len] = 0;
+            eval_line(block + start);
+            break;
+        }
+        if (have == IN_BLOCK) {
+            /* no newline in a whole block: one error line for it, not one per fragment */
+            out_line("Line too long!\n", 15);
+            have = 0;
+            skipping = 1;
+            continue;
+        }
+        memmove(block, block + start, have);
+    }
+    out_flush();
+    free(block);
+    return 0;
+}
+
+int main(int argc, char **argv) {
     char op;
     double num1, num2, result;
 
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        FILE *in = stdin;
+        if (argc > 2 && !(in = fopen(argv[2], "rb"))) {
+            printf("Cannot open %s\n", argv[2]);
+            return 1;
+        }
+        init_ops();
+        int rc = run_batch(in);
+        if (in != stdin) fclose(in);
+        return rc;
+    }
+
     printf("Enter an operator (+, -, *, /): ");
     scanf(" %c", &op);
 
@@ -12,8 +142,7 @@ int main() {
 
     switch(op) {
         case '+':
-           
-        esult = num1 + num2;
+            result = num1 + num2;
             printf("Result: %.2lf\n", result);
             break;
         case '-':
@@ -1,8 +1,180 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
-int main() {
+/* Batch solver.
+   solve_quadratics() takes n triples as three arrays (a[], b[], c[]) and
+   writes three arrays: r1[], r2[] and im[]. For real roots im is 0 and the
+   roots are r1 and r2; for complex ones r1 == r2 is the real part and the
+   roots are r1 + im i and r1 - im i. Real roots use the cancellation-free
+   form q = -(b + sign(b) sqrt(D)) / 2, r1 = q / a, r2 = c / q, so the
+   smaller root keeps its digits when b*b >> 4ac (the textbook form loses
+   them). With a == 0 the results are inf/nan, as in the interactive mode.
+   Both cases are computed for every triple and picked with a mask, so the
+   SIMD loop has no branches.
+
+   CLI:
+     clg --csv [FILE]    : "a,b,c" lines from FILE or stdin, "r1,r2,im" out
+     clg --bin IN OUT    : binary SoA blocks, little-endian: a uint32 count n,
+                           then n doubles of a, n of b, n of c; OUT gets the
+                           same framing with r1, r2, im
+   With no arguments it asks for one triple, as before. */
+
+#define BATCH 65536   /* triples per block */
+
+/* one triple, scalar; the SIMD loops compute exactly this */
+void solve_one(double a, double b, double c, double *r1, double *r2, double *im) {
+    double D = b*b - 4*a*c;
+    double s = sqrt(fabs(D));
+    double q = -0.5 * (b + copysign(s, b));
+    double real = -b / (2*a);
+    int cplx = D < 0;
+    double x1 = q / a;
+    double x2 = q != 0 ? c / q : x1;   /* b == c == 0: both roots are 0 */
+    *r1 = cplx ? real : x1;
+    *r2 = cplx ? real : x2;
+    *im = cplx ? s / (2*a) : 0;
+}
+
+void solve_quadratics(int n, const double *a, const double *b, const double *c, double *r1, double *r2, double *im) {
+    int i = 0;
+#if defined(__AVX__)
+    const __m256d sign = _mm256_set1_pd(-0.0), zero = _mm256_setzero_pd();
+    const __m256d half = _mm256_set1_pd(-0.5), four = _mm256_set1_pd(4.0), two = _mm256_set1_pd(2.0);
+    for (; i + 4 <= n; i += 4) {
+        __m256d A = _mm256_loadu_pd(a + i), B = _mm256_loadu_pd(b + i), C = _mm256_loadu_pd(c + i);
+        __m256d D = _mm256_sub_pd(_mm256_mul_pd(B, B), _mm256_mul_pd(four, _mm256_mul_pd(A, C)));
+        __m256d s = _mm256_sqrt_pd(_mm256_andnot_pd(sign, D));
+        __m256d q = _mm256_mul_pd(half, _mm256_add_pd(B, _mm256_or_pd(s, _mm256_and_pd(sign, B))));
+        __m256d a2 = _mm256_mul_pd(two, A);
+        __m256d real = _mm256_div_pd(_mm256_xor_pd(B, sign), a2);
+        __m256d x1 = _mm256_div_pd(q, A);
+        __m256d x2 = _mm256_blendv_pd(_mm256_div_pd(C, q), x1, _mm256_cmp_pd(q, zero, _CMP_EQ_OQ));
+        __m256d cplx = _mm256_cmp_pd(D, zero, _CMP_LT_OQ);
+        _mm256_storeu_pd(r1 + i, _mm256_blendv_pd(x1, real, cplx));
+        _mm256_storeu_pd(r2 + i, _mm256_blendv_pd(x2, real, cplx));
+        _mm256_storeu_pd(im + i, _mm256_and_pd(cplx, _mm256_div_pd(s, a2)));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    /* SSE2 has no blend: select is (m & x) | (~m & y) */
+    const __m128d sign = _mm_set1_pd(-0.0), zero = _mm_setzero_pd();
+    const __m128d half = _mm_set1_pd(-0.5), four = _mm_set1_pd(4.0), two = _mm_set1_pd(2.0);
+    for (; i + 2 <= n; i += 2) {
+        __m128d A = _mm_loadu_pd(a + i), B = _mm_loadu_pd(b + i), C = _mm_loadu_pd(c + i);
+        __m128d D = _mm_sub_pd(_mm_mul_pd(B, B), _mm_mul_pd(four, _mm_mul_pd(A, C)));
+        __m128d s = _mm_sqrt_pd(_mm_andnot_pd(sign, D));
+        __m128d q = _mm_mul_pd(half, _mm_add_pd(B, _mm_or_pd(s, _mm_and_pd(sign, B))));
+        __m128d a2 = _mm_mul_pd(two, A);
+        __m128d real = _mm_div_pd(_mm_xor_pd(B, sign), a2);
+        __m128d x1 = _mm_div_pd(q, A);
+        __m128d qz = _mm_cmpeq_pd(q, zero);
+        __m128d x2 = _mm_or_pd(_mm_and_pd(qz, x1), _mm_andnot_pd(qz, _mm_div_pd(C, q)));
+        __m128d cplx = _mm_cmplt_pd(D, zero);
+        _mm_storeu_pd(r1 + i, _mm_or_pd(_mm_and_pd(cplx, real), _mm_andnot_pd(cplx, x1)));
+        _mm_storeu_pd(r2 + i, _mm_or_pd(_mm_and_pd(cplx, real), _mm_andnot_pd(cplx, x2)));
+        _mm_storeu_pd(im + i, _mm_and_pd(cplx, _mm_div_pd(s, a2)));
+    }
+#endif
+    for (; i < n; i++) solve_one(a[i], b[i], c[i], &r1[i], &r2[i], &im[i]);
+}
+
+/* the six arrays of one CSV block, allocated together */
+double *block_alloc(double **a, double **b, double **c, double **r1, double **r2, double **im) {
+    double *mem = malloc(6 * (size_t)BATCH * sizeof(double));
+    if (!mem) return NULL;
+    *a = mem; *b = mem + BATCH; *c = mem + 2*BATCH;
+    *r1 = mem + 3*BATCH; *r2 = mem + 4*BATCH; *im = mem + 5*BATCH;
+    return mem;
+}
+
+int run_csv(FILE *in) {
+    double *a, *b, *c, *r1, *r2, *im;
+    double *mem = block_alloc(&a, &b, &c, &r1, &r2, &im);
+    if (!mem) return 1;
+    static char in_buf[1 << 16], out_buf[1 << 16];
+    setvbuf(in, in_buf, _IOFBF, sizeof(in_buf));
+    setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+    char line[256];
+    long line_no = 0;
+    int done = 0;
+    while (!done) {
+        int n = 0;
+        while (n < BATCH) {
+            if (!fgets(line, sizeof(line), in)) { done = 1; break; }
+            line_no++;
+            size_t len = strlen(line);
+            if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(in)) {
+                /* the rest of the line would come back as another row: drop it */
+                int ch;
+                while ((ch = getc(in)) != EOF && ch != '\n') {}
+                fprintf(stderr, "line %ld: longer than %d characters, skipped\n", line_no, (int)sizeof(line) - 2);
+                continue;
+            }
+            char *p = line, *end;
+            a[n] = strtod(p, &end); if (end == p) continue; p = end + (*end == ',');
+            b[n] = strtod(p, &end); if (end == p) continue; p = end + (*end == ',');
+            c[n] = strtod(p, &end); if (end == p) continue;
+            n++;
+        }
+        solve_quadratics(n, a, b, c, r1, r2, im);
+        for (int i=0;i<n;i++) printf("%.17g,%.17g,%.17g\n", r1[i], r2[i], im[i]);
+    }
+    fflush(stdout);
+    free(mem);
+    return 0;
+}
+
+unsigned read_u32le(const unsigned char *p) { return p[0] | p[1] << 8 | p[2] << 16 | (unsigned)p[3] << 24; }
+
+/* doubles are read and written in host order: little-endian on the
+   machines this runs on */
+int run_bin(const char *in_path, const char *out_path) {
+    FILE *in = fopen(in_path, "rb"), *out = fopen(out_path, "wb");
+    if (!in || !out) {
+        printf("Cannot open %s\n", !in ? in_path : out_path);
+        if (in) fclose(in);
+        if (out) fclose(out);
+        return 1;
+    }
+    unsigned char hdr[4];
+    int rc = 0;
+    while (fread(hdr, 4, 1, in) == 1) {
+        unsigned n = read_u32le(hdr);
+        if (n > 0x7fffffff / 3) { printf("Block too large\n"); rc = 1; break; }
+        double *blk = malloc(3 * (size_t)n * sizeof(double));
+        if (!blk && n) { rc = 1; break; }
+        if (fread(blk, sizeof(double), 3 * (size_t)n, in) != 3 * (size_t)n) { printf("Truncated block\n"); free(blk); rc = 1; break; }
+        fwrite(hdr, 4, 1, out);
+        double *res = malloc(3 * (size_t)n * sizeof(double));
+        if (!res && n) { free(blk); rc = 1; break; }
+        solve_quadratics((int)n, blk, blk + n, blk + 2*(size_t)n, res, res + n, res + 2*(size_t)n);
+        fwrite(res, sizeof(double), 3 * (size_t)n, out);
+        free(blk);
+        free(res);
+    }
+    fclose(in);
+    if (fclose(out) != 0) rc = 1;
+    return rc;
+}
+
+int main(int argc, char **argv) {
     double a, b, c, D, r1, r2, img, real;
+
+    if (argc > 1 && strcmp(argv[1], "--csv") == 0) {
+        FILE *in = argc > 2 ? fopen(argv[2], "r") : stdin;
+        if (!in) { printf("Cannot open %s\n", argv[2]); return 1; }
+        int rc = run_csv(in);
+        if (in != stdin) fclose(in);
+        return rc;
+    }
+    if (argc > 3 && strcmp(argv[1], "--bin") == 0) return run_bin(argv[2], argv[3]);
+
     printf("Enter values for a, b, and c: ");
     scanf("%lf%lf%lf", &a, &b, &c);
 
@@ -1,21 +1,188 @@
 # include <stdio.h>
- void main()
+# include <stdlib.h>
+# include <string.h>
+# include <pthread.h>
+
+/* Range mode: "clg 2" LO HI [--print] [--threads N]
+   Counts (or prints, one per line in increasing order) every palindrome in
+   [LO, HI], both unsigned 64-bit. Palindromes are built directly: for each
+   digit length, the first half of the digits is counted up and mirrored,
+   so no candidate is ever reversed or tested. Counting needs just the end
+   halves of each length; printing splits the halves across threads. */
+
+typedef unsigned long long u64;
+
+#define BLOCK_HALVES (1u << 18)   /* halves per thread per round when printing */
+#define MAX_THREADS 64
+
+/* "00".."99", two characters per entry */
+char digit_pairs[201];
+
+void init_digit_pairs(void) {
+    for (int i=0;i<100;i++){
+        digit_pairs[2*i] = (char)('0' + i / 10);
+        digit_pairs[2*i+1] = (char)('0' + i % 10);
+    }
+}
+
+/* write v as exactly n digits (zero-padded) at out, two at a time */
+void put_digits(u64 v, int n, char *out) {
+    int i = n;
+    while (i >= 2) {
+        memcpy(out + i - 2, digit_pairs + 2 * (v % 100), 2);
+        v /= 100;
+        i -= 2;
+    }
+    if (i == 1) out[0] = (char)('0' + v % 10);
+}
+
+int num_digits(u64 v) {
+    int n = 1;
+    while (v >= 10) { v /= 10; n++; }
+    return n;
+}
+
+u64 pow10u(int n) {
+    u64 p = 1;
+    while (n-- > 0) p *= 10;
+    return p;
+}
+
+/* the len-digit palindrome whose first (len+1)/2 digits are h, as text */
+void mirror_text(u64 h, int len, char *out) {
+    int half = (len + 1) / 2;
+    put_digits(h, half, out);
+    for (int i=half;i<len;i++) out[i] = out[len - 1 - i];
+}
+
+/* Halves [*hmin, *hmax] of the len-digit palindromes inside [lo, hi]
+   (lo_txt / hi_txt are their decimal text); returns 0 if there are none.
+   Equal-length decimal text compares like the numbers, which keeps
+   20-digit palindromes above 2^64 out of u64 arithmetic. */
+int halves_in_range(int len, const char *lo_txt, const char *hi_txt, u64 *hmin, u64 *hmax) {
+    int half = (len + 1) / 2;
+    char buf[21];
+    buf[len] = 0;
+    *hmin = len == 1 ? 0 : pow10u(half - 1);
+    *hmax = pow10u(half) - 1;
+    if ((int)strlen(lo_txt) == len) {
+        *hmin = strtoull(lo_txt, NULL, 10) / pow10u(len - half);
+        mirror_text(*hmin, len, buf);
+        if (strcmp(buf, lo_txt) < 0) ++*hmin;
+    }
+    if ((int)strlen(hi_txt) == len) {
+        *hmax = strtoull(hi_txt, NULL, 10) / pow10u(len - half);
+        mirror_text(*hmax, len, buf);
+        if (strcmp(buf, hi_txt) > 0) {
+            if (*hmax == 0) return 0;
+            --*hmax;
+        }
+    }
+    return *hmin <= *hmax;
+}
+
+typedef struct {
+    int len;
+    u64 first, count;   /* halves [first, first + count) */
+    char *out;          /* count * (len + 1) bytes */
+} PrintJob;
+
+/* palindrome text for a run of halves: the half is incremented as text, so
+   each palindrome costs a carry and a mirrored copy */
+void *print_job(void *arg) {
+    PrintJob *job = arg;
+    int len = job->len, half = (len + 1) / 2;
+    char cur[21];
+    put_digits(job->first, half, cur);
+    char *p = job->out;
+    for (u64 k=0;k<job->count;k++){
+        memcpy(p, cur, half);
+        for (int i=half;i<len;i++) p[i] = cur[len - 1 - i];
+        p[len] = '\n';
+        p += len + 1;
+        int i = half - 1;
+        while (i >= 0 && cur[i] == '9') cur[i--] = '0';
+        if (i >= 0) cur[i]++;
+    }
+    return NULL;
+}
+
+void print_halves(int len, u64 hmin, u64 hmax, int threads) {
+    pthread_t tid[MAX_THREADS];
+    PrintJob jobs[MAX_THREADS];
+    char *bufs[MAX_THREADS];
+    for (int t=0;t<threads;t++){
+        bufs[t] = malloc((size_t)BLOCK_HALVES * (len + 1));
+        if (!bufs[t]) { printf("out of memory\n"); exit(1); }
+    }
+    u64 next = hmin;
+    while (next <= hmax) {
+        int used = 0;
+        for (int t=0;t<threads && next <= hmax;t++){
+            u64 n = hmax - next + 1;
+            if (n > BLOCK_HALVES) n = BLOCK_HALVES;
+            jobs[t] = (PrintJob){len, next, n, bufs[t]};
+            next += n;
+            used++;
+        }
+        for (int t=1;t<used;t++) pthread_create(&tid[t], NULL, print_job, &jobs[t]);
+        print_job(&jobs[0]);
+        for (int t=1;t<used;t++) pthread_join(tid[t], NULL);
+        for (int t=0;t<used;t++) fwrite(jobs[t].out, len + 1, jobs[t].count, stdout);
+    }
+    for (int t=0;t<threads;t++) free(bufs[t]);
+}
+
+int run_range(u64 lo, u64 hi, int print, int threads) {
+    char lo_txt[21], hi_txt[21];
+    snprintf(lo_txt, sizeof(lo_txt), "%llu", lo);
+    snprintf(hi_txt, sizeof(hi_txt), "%llu", hi);
+    static char out_buf[1 << 16];
+    setvbuf(stdout, out_buf, _IOFBF, sizeof(out_buf));
+    u64 total = 0;
+    for (int len=num_digits(lo);len<=num_digits(hi);len++){
+        u64 hmin, hmax;
+        if (!halves_in_range(len, lo_txt, hi_txt, &hmin, &hmax)) continue;
+        total += hmax - hmin + 1;
+        if (print) print_halves(len, hmin, hmax, threads);
+    }
+    if (!print) printf("%llu palindromes in [%llu, %llu]\n", total, lo, hi);
+    return 0;
+}
+
+ int main(int argc, char **argv)
  {
- 	 int h,rev=0 ,rem,tem;
+ 	 u64 h,rev=0 ,rem,tem;
+ 	 if (argc >= 3)
+ 	 {
+ 	  u64 lo = strtoull(argv[1], NULL, 10), hi = strtoull(argv[2], NULL, 10);
+ 	  int print = 0, threads = 4;
+ 	  for (int i=3;i<argc;i++)
+ 	  {
+ 	   if (strcmp(argv[i], "--print") == 0) print = 1;
+ 	   else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) threads = atoi(argv[++i]);
+ 	  }
+ 	  if (threads < 1) threads = 1;
+ 	  if (threads > MAX_THREADS) threads = MAX_THREADS;
+ 	  if (lo > hi) { printf("LO must not be above HI\n"); return 1; }
+ 	  init_digit_pairs();
+ 	  return run_range(lo, hi, print, threads);
+ 	 }
  	 		printf("enter number:");
- 	  scanf("%d",&h);
+ 	  scanf("%llu",&h);
  	  tem=h;
- 	  while(h!=0)
+ 	  /* reverse only the lower half, so rev can never overflow */
+ 	  while(h>rev)
  {
  rem=h%10;
   rev=rev*10+rem;
    h=h/10;
 }
- if (rev==tem)
- {printf("%d is palidrome",tem);
- 
+ if ((h==rev || h==rev/10) && (tem%10!=0 || tem==0))
+ {printf("%llu is palidrome",tem);
+
  }
- else{ printf("%d is not palidrome");
+ else{ printf("%llu is not palidrome",tem);
  }
  return 0;
 }
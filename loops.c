@@ -1,10 +1,36 @@
 #include<stdio.h>
-  void main(){
-  	int i,j;
-	  for(i=1;i<10;i+=4){ 
-       for(j=1;j<i;j++)
-	   {printf("*");
-	   }
-	  	printf("*\n");
-	  } 	
+#include<stdlib.h>
+#include<string.h>
+
+/* loops [HEIGHT [STEP]]: the star triangle with rows of 1, 1+STEP,
+   1+2*STEP, ... stars, below HEIGHT (default 10 and 4, the original
+   pattern). Each row is the previous one plus STEP stars memset onto the
+   end of one reusable row buffer, and rows are collected into a big
+   output chunk that goes out in a single fwrite. */
+
+#define OUT_CHUNK (1 << 20)
+
+  int main(int argc, char **argv){
+  	long height = argc > 1 ? atol(argv[1]) : 10;
+  	long step = argc > 2 ? atol(argv[2]) : 4;
+  	if (step < 1) step = 1;
+  	/* longest row: the last i below height, plus its newline */
+  	long longest = height > 1 ? 1 + (height - 2) / step * step : 0;
+  	char *row = malloc(longest + 1);
+  	char *out = malloc(OUT_CHUNK);
+  	if (!row || !out) return 1;
+  	long len = 0;   /* stars currently in row */
+  	size_t used = 0;
+	  for(long i=1;i<height;i+=step){
+	   memset(row + len, '*', i - len);
+	   len = i;
+	   row[len] = '\n';
+	   if (used + len + 1 > OUT_CHUNK) { fwrite(out, 1, used, stdout); used = 0; }
+	   if (len + 1 > OUT_CHUNK) fwrite(row, 1, len + 1, stdout);   /* a row bigger than the chunk */
+	   else { memcpy(out + used, row, len + 1); used += len + 1; }
+	  }
+	  fwrite(out, 1, used, stdout);
+	  free(row);
+	  free(out);
+	  return 0;
   }
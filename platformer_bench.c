@@ -0,0 +1,225 @@
+/* platformer_bench.c
+   Microbenchmarks for the platformer's hot paths (Untitled-1.c is compiled
+   in as a library). Each benchmark runs against the first built-in level
+   and synthetic levels up to 10000x64 tiles, drawing into an offscreen
+   software renderer, and prints ns per call and per element, plus how the
+   per-call time grows against the smallest map (the scaling curve).
+   - Compile (Linux/macOS):
+       gcc -O2 platformer_bench.c -o platformer_bench $(sdl2-config --cflags --libs) -lSDL2_ttf -lm
+   - Run:  platformer_bench [NAME]   (only benchmarks whose name contains NAME)
+*/
+
+#define RETRO_NO_MAIN
+#include "Untitled-1.c"
+
+#define BENCH_MIN_SECONDS 0.2   /* each measurement repeats for at least this long */
+
+typedef struct {
+    const char *name;
+    int cols, rows;     /* 0: the first built-in level */
+} MapSize;
+
+MapSize bench_maps[] = {
+    {"builtin 80x8", 0, 0},
+    {"1000x16", 1000, 16},
+    {"4000x32", 4000, 32},
+    {"10000x64", 10000, 64},
+};
+#define BENCH_MAPS (int)(sizeof(bench_maps) / sizeof(bench_maps[0]))
+
+/* one time per map for the scaling column */
+typedef struct {
+    const char *bench;
+    double base_ns;     /* ns/op on the first map run */
+} Curve;
+
+Uint32 bench_rng = 12345;
+int bench_rand(int n) {
+    bench_rng = bench_rng * 1664525u + 1013904223u;
+    return (int)((bench_rng >> 16) % (Uint32)n);
+}
+
+/* A long level in the LEVELS legend: two ground rows with pits, 't' and
+   '=' platforms, and coins, enemies and mushrooms at roughly the built-in
+   levels' density. rows[] and the strings are malloc'd. */
+char **make_map(int cols, int rows) {
+    char **map = malloc(rows * sizeof(char *));
+    for (int j=0;j<rows;j++){
+        map[j] = malloc(cols + 1);
+        memset(map[j], ' ', cols);
+        map[j][cols] = 0;
+    }
+    for (int i=0;i<cols;i++){
+        int pit = i > 10 && i < cols - 10 && bench_rand(40) == 0;
+        if (!pit) map[rows-1][i] = map[rows-2][i] = 'X';
+        if (pit && i + 1 < cols) { i++; continue; }
+        if (bench_rand(6) == 0) map[rows-3][i] = 'C';
+        else if (bench_rand(14) == 0) map[rows-3][i] = 'E';
+        else if (bench_rand(120) == 0) map[rows-3][i] = 'M';
+    }
+    /* platforms, with coins on top */
+    for (int i=4;i+8<cols;i+=6+bench_rand(10)){
+        int y = 2 + bench_rand(rows - 6 > 1 ? rows - 6 : 1);
+        int w = 2 + bench_rand(6);
+        char kind = bench_rand(2) ? 't' : '=';
+        for (int k=0;k<w;k++){
+            map[y][i+k] = kind;
+            if (y > 0 && bench_rand(3) == 0) map[y-1][i+k] = 'C';
+        }
+    }
+    map[rows-3][cols-4] = 'F';
+    return map;
+}
+
+void free_map(char **map, int rows) {
+    for (int j=0;j<rows;j++) free(map[j]);
+    free(map);
+}
+
+/* call fn(ctx) until BENCH_MIN_SECONDS have passed; ns per call */
+double bench_time(void (*fn)(void *), void *ctx) {
+    const double freq = (double)SDL_GetPerformanceFrequency();
+    long calls = 0, batch = 1;
+    Uint64 t0 = SDL_GetPerformanceCounter(), t;
+    do {
+        for (long i=0;i<batch;i++) fn(ctx);
+        calls += batch;
+        if (batch < (1 << 20)) batch *= 2;
+        t = SDL_GetPerformanceCounter();
+    } while ((t - t0) / freq < BENCH_MIN_SECONDS);
+    return (t - t0) / freq * 1e9 / calls;
+}
+
+const char *bench_filter = NULL;
+Curve curves[16];
+int curve_count = 0;
+
+/* print one result row; elems is what ns/elem divides by */
+void report(const char *bench, const char *map, double ns, double elems) {
+    Curve *c = NULL;
+    for (int i=0;i<curve_count;i++) if (strcmp(curves[i].bench, bench) == 0) c = &curves[i];
+    if (!c && curve_count < 16) { c = &curves[curve_count++]; c->bench = bench; c->base_ns = ns; }
+    printf("%-22s %-14s %14.1f %12.3f %9.2fx\n", bench, map, ns, elems > 0 ? ns / elems : 0.0, c && c->base_ns > 0 ? ns / c->base_ns : 1.0);
+}
+
+int wanted(const char *bench) {
+    return !bench_filter || strstr(bench, bench_filter) != NULL;
+}
+
+/* ---- the benchmarks; each takes a context with the level under test ---- */
+typedef struct {
+    World world;
+    const char **rows;
+    int nrows;
+    Player player;
+    int probe;          /* rotating position for the per-call probes */
+    int probe_row;
+    SDL_Renderer *ren;
+    int hits;           /* keeps the pickup scans from being optimized out */
+} Bench;
+
+void do_build(void *p) {
+    Bench *b = p;
+    build_level(&b->world, b->rows, b->nrows);
+}
+
+/* a player box walking and falling in a different spot on every call */
+void do_collide(void *p) {
+    Bench *b = p;
+    Player *pl = &b->player;
+    b->probe = (b->probe + 97) % (b->world.width > TILE ? b->world.width - TILE : 1);
+    pl->r.x = (float)b->probe;
+    b->probe_row = (b->probe_row + 1) % b->world.grid_rows;
+    pl->r.y = (float)(b->probe_row * TILE);
+    resolve_horz_collision(&b->world, pl, 3.0f);
+    resolve_vert_collision(&b->world, pl, 6.0f);
+}
+
+void do_enemies(void *p) {
+    Bench *b = p;
+    update_enemies(&b->world, 0, b->world.enemies.count, 1.0f / 60);
+}
+
+/* the pickup loops' scan, over the whole coin store */
+void do_pickup_full(void *p) {
+    Bench *b = p;
+    CoinStore *c = &b->world.coins;
+    b->probe = (b->probe + 97) % (b->world.width > TILE ? b->world.width : 1);
+    SDL_Rect pr = {b->probe, (b->world.grid_rows - 3) * TILE, TILE - 12, TILE - 8};
+    for (int i = overlap_next(pr, c->x, c->y, c->w, c->h, 0, c->count); i < c->count; i = overlap_next(pr, c->x, c->y, c->w, c->h, i + 1, c->count)) b->hits++;
+}
+
+/* ... and over just the player's span of the x-sorted store, as sim_tick does */
+void do_pickup_span(void *p) {
+    Bench *b = p;
+    CoinStore *c = &b->world.coins;
+    b->probe = (b->probe + 97) % (b->world.width > TILE ? b->world.width : 1);
+    SDL_Rect pr = {b->probe, (b->world.grid_rows - 3) * TILE, TILE - 12, TILE - 8};
+    int lo, hi;
+    store_span(c->x, c->count, pr.x, pr.x + pr.w, &lo, &hi);
+    for (int i = overlap_next(pr, c->x, c->y, c->w, c->h, lo, hi); i < hi; i = overlap_next(pr, c->x, c->y, c->w, c->h, i + 1, hi)) b->hits++;
+}
+
+/* one frame of the play view: level chunks, entities, flag and player */
+void do_draw(void *p) {
+    Bench *b = p;
+    World *world = &b->world;
+    b->probe = (b->probe + 7 * TILE) % (world->width > SCREEN_W ? world->width - SCREEN_W : 1);
+    int camx = b->probe, lo, hi;
+    render_batches = 0;
+    draw_level(b->ren, world, camx);
+    store_span(world->coins.x, world->coins.count, camx, camx + SCREEN_W, &lo, &hi);
+    for (int i=lo;i<hi;i++) draw_coin(b->ren, coin_rect(world, i), camx);
+    store_span(world->mush.x, world->mush.count, camx, camx + SCREEN_W, &lo, &hi);
+    for (int i=lo;i<hi;i++) draw_mush(b->ren, mush_rect(world, i), camx);
+    store_span(world->enemies.x, world->enemies.count, camx, camx + SCREEN_W, &lo, &hi);
+    for (int i=lo;i<hi;i++) draw_enemy(b->ren, enemy_rect(world, i), camx);
+    if (world->goal_exists) draw_flag(b->ren, world->goal_rect, camx);
+    b->player.r.x = (float)(camx + SCREEN_W / 2);
+    b->player.r.y = (float)((world->grid_rows - 3) * TILE);
+    draw_player(b->ren, &b->player, camx);
+    render_flush(b->ren);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) bench_filter = argv[1];
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_W, SCREEN_H, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer *ren = target ? SDL_CreateSoftwareRenderer(target) : NULL;
+    if (!ren) { fprintf(stderr, "software renderer: %s\n", SDL_GetError()); return 1; }
+    jobs_init();
+    printf("%-22s %-14s %14s %12s %10s\n", "benchmark", "map", "ns/op", "ns/elem", "vs first");
+    for (int m=0;m<BENCH_MAPS;m++){
+        MapSize *ms = &bench_maps[m];
+        Bench b = {0};
+        char **owned = NULL;
+        if (ms->cols == 0) {
+            b.rows = LEVELS[0];
+            b.nrows = 8;
+        } else {
+            owned = make_map(ms->cols, ms->rows);
+            b.rows = (const char **)owned;
+            b.nrows = ms->rows;
+        }
+        b.ren = ren;
+        b.player.r.w = TILE - 12; b.player.r.h = TILE - 8;
+        build_level(&b.world, b.rows, b.nrows);
+        double cells = (double)b.world.grid_cols * b.world.grid_rows;
+        if (wanted("build_level")) report("build_level", ms->name, bench_time(do_build, &b), cells);
+        if (wanted("collide")) report("collide (horz+vert)", ms->name, bench_time(do_collide, &b), 1);
+        if (wanted("update_enemies")) report("update_enemies", ms->name, bench_time(do_enemies, &b), b.world.enemies.count);
+        /* enemies moved; start the rest from the pristine level */
+        build_level(&b.world, b.rows, b.nrows);
+        if (wanted("pickup")) {
+            report("pickup scan (full)", ms->name, bench_time(do_pickup_full, &b), b.world.coins.count);
+            report("pickup scan (span)", ms->name, bench_time(do_pickup_span, &b), 1);
+        }
+        if (wanted("draw")) report("draw frame", ms->name, bench_time(do_draw, &b), 1);
+        free_level_chunks();
+        arena_free(&b.world.arena);
+        if (owned) free_map(owned, ms->rows);
+    }
+    jobs_shutdown();
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    return 0;
+}
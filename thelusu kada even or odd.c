@@ -1,20 +1,222 @@
 #include <stdio.h>
-  void main(){
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Streaming mode: "thelusu kada even or odd" --pairs|--seq FILE [--threads N]
+   FILE is raw 32-bit ints (host byte order). --pairs compares (x0, x1),
+   (x2, x3), ... as num1 against num2; --seq compares every neighbour pair
+   (x[i], x[i+1]). Prints how often num1 was greater / equal / less, and the
+   minimum and maximum of all values with the index of their first
+   occurrence. The file is read in BLOCK-value blocks; each block is split
+   across the threads, and every part keeps its own counts and min/max
+   (AVX2 compare masks and blends, or plain C), which are reduced at the
+   end. */
+
+#define BLOCK (1 << 22)   /* values per read */
+#define MAX_THREADS 64
+
+typedef struct {
+    long long gt, eq, lt;
+    int min, max;
+    long long min_at, max_at;   /* -1 until a value was seen */
+} Stats;
+
+void stats_init(Stats *s) {
+    memset(s, 0, sizeof(*s));
+    s->min_at = s->max_at = -1;
+}
+
+/* fold b into a; on ties the earlier index wins */
+void stats_merge(Stats *a, const Stats *b) {
+    a->gt += b->gt; a->eq += b->eq; a->lt += b->lt;
+    if (b->min_at >= 0 && (a->min_at < 0 || b->min < a->min || (b->min == a->min && b->min_at < a->min_at))) { a->min = b->min; a->min_at = b->min_at; }
+    if (b->max_at >= 0 && (a->max_at < 0 || b->max > a->max || (b->max == a->max && b->max_at < a->max_at))) { a->max = b->max; a->max_at = b->max_at; }
+}
+
+/* min/max of v[0..n), indices offset by base */
+void scan_minmax(const int *v, int n, long long base, Stats *s) {
+    int i = 0;
+    Stats part;
+    stats_init(&part);
+#if defined(__AVX2__)
+    if (n >= 8) {
+        __m256i vmin = _mm256_loadu_si256((const __m256i *)v), vmax = vmin;
+        __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), imin = idx, imax = idx;
+        const __m256i eight = _mm256_set1_epi32(8);
+        for (i = 8; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(v + i));
+            idx = _mm256_add_epi32(idx, eight);
+            /* strict compares keep the first index of each lane's extreme */
+            __m256i lt = _mm256_cmpgt_epi32(vmin, x), gt = _mm256_cmpgt_epi32(x, vmax);
+            vmin = _mm256_blendv_epi8(vmin, x, lt); imin = _mm256_blendv_epi8(imin, idx, lt);
+            vmax = _mm256_blendv_epi8(vmax, x, gt); imax = _mm256_blendv_epi8(imax, idx, gt);
+        }
+        int mn[8], mx[8], in[8], ix[8];
+        _mm256_storeu_si256((__m256i *)mn, vmin); _mm256_storeu_si256((__m256i *)in, imin);
+        _mm256_storeu_si256((__m256i *)mx, vmax); _mm256_storeu_si256((__m256i *)ix, imax);
+        for (int l=0;l<8;l++){
+            Stats lane;
+            stats_init(&lane);
+            lane.min = mn[l]; lane.min_at = in[l];
+            lane.max = mx[l]; lane.max_at = ix[l];
+            stats_merge(&part, &lane);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (part.min_at < 0 || v[i] < part.min) { part.min = v[i]; part.min_at = i; }
+        if (part.max_at < 0 || v[i] > part.max) { part.max = v[i]; part.max_at = i; }
+    }
+    if (part.min_at >= 0) { part.min_at += base; part.max_at += base; }
+    stats_merge(s, &part);
+}
+
+/* greater / less counts of v[k*step] against v[k*step + 1] for k < n
+   (step 2: pairs, step 1: neighbours); equal is the rest */
+void scan_compare(const int *v, int n, int step, Stats *s) {
+    int k = 0;
+#if defined(__AVX2__)
+    if (step == 1) {
+        for (; k + 8 <= n; k += 8) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(v + k)), b = _mm256_loadu_si256((const __m256i *)(v + k + 1));
+            s->gt += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))));
+            s->lt += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a))));
+        }
+    } else {
+        /* 4 pairs per load: swap each pair's halves and look at the even lanes */
+        for (; k + 4 <= n; k += 4) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)(v + 2*k));
+            __m256i b = _mm256_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1));
+            s->gt += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))) & 0x55);
+            s->lt += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(b, a))) & 0x55);
+        }
+    }
+#endif
+    long long gt = 0, lt = 0;
+    for (; k < n; k++) {
+        int a = v[k * step], b = v[k * step + 1];
+        gt += a > b;
+        lt += a < b;
+    }
+    s->gt += gt;
+    s->lt += lt;
+}
+
+typedef struct {
+    const int *v;
+    int n;              /* values in this part */
+    int compares;       /* comparisons starting in this part */
+    int step;
+    long long base;     /* file index of v[0] */
+    Stats stats;
+    pthread_t tid;
+} Part;
+
+void *part_main(void *arg) {
+    Part *p = arg;
+    stats_init(&p->stats);
+    scan_minmax(p->v, p->n, p->base, &p->stats);
+    Stats c;
+    stats_init(&c);
+    scan_compare(p->v, p->compares, p->step, &c);
+    c.eq = p->compares - c.gt - c.lt;
+    stats_merge(&p->stats, &c);
+    return NULL;
+}
+
+int run_stream(const char *path, int step, int threads) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { printf("Cannot open %s\n", path); return 1; }
+    /* one spare slot in front for the last value of the previous block */
+    int *buf = malloc((BLOCK + 1) * sizeof(int));
+    if (!buf) return 1;
+    Part parts[MAX_THREADS];
+    Stats total;
+    stats_init(&total);
+    long long seen = 0;
+    int carry = 0, have_carry = 0;
+    size_t got;
+    while ((got = fread(buf + 1, sizeof(int), BLOCK, f)) > 0) {
+        int n = (int)got;
+        if (step == 1 && have_carry) {
+            /* the neighbour pair that straddles two blocks */
+            buf[0] = carry;
+            total.gt += buf[0] > buf[1]; total.lt += buf[0] < buf[1]; total.eq += buf[0] == buf[1];
+        }
+        /* BLOCK is even, so only the file's last value can be left without a
+           pair: it takes part in min/max and the count, not in comparisons */
+        int unpaired = step == 2 && n % 2;
+        if (unpaired) n--;
+        int *v = buf + 1;
+        if (unpaired && n == 0) {
+            scan_minmax(v, 1, seen, &total);
+            fprintf(stderr, "note: odd number of values, the last one (index %lld) has no pair\n", seen);
+            seen++;
+            break;
+        }
+        if (n == 0) break;
+        /* split on pair boundaries; for --seq a part's last compare reads one past it */
+        int per = (n + threads - 1) / threads;
+        per += per & 1;
+        int used = 0;
+        for (int off=0;off<n && used<threads;off+=per){
+            Part *p = &parts[used++];
+            p->v = v + off;
+            p->n = n - off < per ? n - off : per;
+            p->step = step;
+            p->base = seen + off;
+            int end = off + p->n;
+            p->compares = step == 2 ? p->n / 2 : (end < n ? p->n : p->n - 1);
+        }
+        for (int t=1;t<used;t++) pthread_create(&parts[t].tid, NULL, part_main, &parts[t]);
+        part_main(&parts[0]);
+        for (int t=1;t<used;t++) pthread_join(parts[t].tid, NULL);
+        for (int t=0;t<used;t++) stats_merge(&total, &parts[t].stats);
+        carry = v[n - 1];
+        have_carry = 1;
+        if (unpaired) {
+            scan_minmax(v + n, 1, seen + n, &total);
+            fprintf(stderr, "note: odd number of values, the last one (index %lld) has no pair\n", seen + n);
+            seen += n + 1;
+            break;
+        }
+        seen += n;
+    }
+    fclose(f);
+    free(buf);
+    printf("%lld values, %lld comparisons: num1 greater %lld, equal %lld, num2 greater %lld\n",
+           seen, total.gt + total.eq + total.lt, total.gt, total.eq, total.lt);
+    if (seen > 0) printf("min %d at index %lld, max %d at index %lld\n", total.min, total.min_at, total.max, total.max_at);
+    return 0;
+}
+
+  int main(int argc, char **argv){
   	 int num1,num2;
+  	 if (argc >= 3 && (strcmp(argv[1], "--pairs") == 0 || strcmp(argv[1], "--seq") == 0)) {
+  	 	int threads = 4;
+  	 	if (argc >= 5 && strcmp(argv[3], "--threads") == 0) threads = atoi(argv[4]);
+  	 	if (threads < 1) threads = 1;
+  	 	if (threads > MAX_THREADS) threads = MAX_THREADS;
+  	 	return run_stream(argv[2], strcmp(argv[1], "--pairs") == 0 ? 2 : 1, threads);
+  	 }
   	 printf("enter a num1,num2");
   	 scanf("%d%d",&num1,&num2);
-  	   
-  	 
+
+
   	if(num1>num2){
   		printf(" num1 is greater");
-  	
+
 	  }
 	   else if(num1==num2){
 	  		printf("both are equal");}
-	 
+
 	  else{
 	  	printf("num2 is greater ");
-	  	
+
 		  }
-	 
+	 return 0;
   }